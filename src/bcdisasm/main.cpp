@@ -1,4 +1,5 @@
 #include "bytecode.hpp"
+#include "loader.hpp"
 #include <boost/program_options.hpp>
 #include <cstdint>
 #include <fstream>
@@ -35,43 +36,6 @@ static inline std::string HEX(uint64_t no, std::string suffix = "h") {
     return stream.str();
 }
 
-Operand readOperand(const std::vector<uint8_t>& buf, size_t& pc) {
-    Operand op {};
-    if(pc + 2 > buf.size())
-        return op;
-
-    op.type = static_cast<OperandType>(buf[pc++]);
-    op.data = 0;
-
-    for(int i = 0; pc < buf.size(); i++)
-        op.data |= uint32_t(buf[pc++]) << (8 * i);
-
-    return op;
-}
-
-Instruction readInstruction(const std::vector<uint8_t>& buf, size_t& pc) {
-    Instruction instr {};
-    instr.offset = pc;
-
-    if(pc + 11 >= buf.size())
-        return instr;
-
-    instr.opcode = static_cast<Opcode>(buf[pc++]);
-
-    for(uint8_t i = 0; i < 2; ++i) {
-        Operand op{};
-        op.type = static_cast<OperandType>(buf[pc++]);
-        op.data = 0;
-
-        for(int b = 0; b < 4; b++)
-            op.data |= uint32_t(buf[pc++]) << (8 * b);
-
-        instr.operands.push_back(op);
-    }
-
-    return instr;
-}
-
 MetaData readMeta(const std::vector<uint8_t>& buf, const BytecodeHeader& hdr) {
     MetaData meta {};
     if(hdr.meta_size == 0)
@@ -108,19 +72,25 @@ MetaData readMeta(const std::vector<uint8_t>& buf, const BytecodeHeader& hdr) {
     return meta;
 }
 
-std::string fmtOperand(const Operand& operand, const MetaData& meta, bool do_sym) {
+std::string fmtOperand(const Operand& operand, const MetaData& meta, const ProgramData& data, bool do_sym) {
     std::string out;
 
     switch (operand.type) {
         case OperandType::OP_NULL:
             return "";
 
-        case OperandType::OP_IMMEDIATE:
-        case OperandType::OP_CONSTANT: {
+        case OperandType::OP_IMMEDIATE: {
             uint64_t val = operand.data;
             return HEX(val);
         }
 
+        case OperandType::OP_CONSTANT: {
+            if(operand.data >= data.const_count)
+                return "$" + std::to_string(operand.data) + "(?)";
+
+            return "$" + std::to_string(operand.data) + "(" + HEX(data.constants[operand.data]) + ")";
+        }
+
         case OperandType::OP_REFERENCE: {
             uint64_t val = operand.data;
 
@@ -193,28 +163,45 @@ int main(int argc, char** argv) {
     MetaData meta = readMeta(buf, hdr);
 
     std::vector<Instruction> instructions;
-
-    size_t pc = hdr.code_offset;
-    while(pc < hdr.code_offset + hdr.code_size && pc < buf.size()) {
-        Instruction instr = readInstruction(buf, pc);
-        instructions.push_back(instr);
+    ProgramData data;
+    try {
+        verifyChecksum(buf, hdr);
+        unpackSections(buf, hdr);
+        instructions = loadProgram(buf, hdr);
+        data = loadData(buf, hdr);
+    } catch(std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
     }
 
-    std::cout << "Instructions read: " << instructions.size() << std::endl;
+    std::cout << "Instructions read: " << instructions.size() << ", constants: " << std::dec << data.const_count 
+              << ((hdr.flags & BC_FLAG_COMPACT) ? ", compact" : "")
+              << ((hdr.flags & BC_FLAG_OPTIMIZED) ? ", optimized" : "") << std::endl;
+
+    size_t code_end = hdr.code_offset + hdr.code_size;
 
-    for(const auto& instr: instructions) {
+    for(size_t n = 0; n < instructions.size(); n++) {
+        const Instruction& instr = instructions[n];
         std::cout << std::setw(8) << std::setfill('0') << std::hex << instr.offset << " | ";
 
         if(do_bin) {
-            size_t instr_end = instr.offset + 1 + /*opA.size + opB.size*/ sizeof(uint32_t) * 2;
+            // instructions are variable-length in compact code
+            size_t instr_end = n + 1 < instructions.size() ? instructions[n + 1].offset : code_end;
             for(size_t i = instr.offset; i < instr_end && i < buf.size(); ++i)
                 std::cout << std::setw(2) << std::setfill('0') << std::hex << (int) buf[i] << " ";
             std::cout << " | ";
         }
 
         std::cout << opcodeToStr(instr.opcode);
-        for(const auto& op : instr.operands) {
-            std::cout << " " << fmtOperand(op, meta, do_sym);
+        for(size_t i = 0; i < instr.operands.size(); i++) {
+            const Operand& op = instr.operands[i];
+
+            if(op.type == OperandType::OP_REGISTER && isVectorOperand(instr.opcode, i))
+                std::cout << " V" << std::dec << op.data << std::hex;
+            else if(branchTargetOperand(instr.opcode) == static_cast<int>(i))
+                std::cout << " @" << std::setw(8) << std::setfill('0') << (op.data < instructions.size() ? instructions[op.data].offset : code_end);
+            else
+                std::cout << " " << fmtOperand(op, meta, data, do_sym);
         }
 
         std::cout << std::endl;
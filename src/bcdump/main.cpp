@@ -1,5 +1,8 @@
 #include "bytecode.hpp"
+#include "loader.hpp"
+#include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -16,10 +19,50 @@ void dumpHeader(const BytecodeHeader& hdr) {
     std::cout << "  Word size : " << int(hdr.word_size) << "\n";
     std::cout << "Code offset : " << hdr.code_offset << "\n";
     std::cout << "  Code size : " << hdr.code_size << "\n";
+    std::cout << "Data offset : " << hdr.data_offset << "\n";
+    std::cout << "  Data size : " << hdr.data_size << "\n";
     std::cout << "Meta offset : " << hdr.meta_offset << "\n";
     std::cout << "  Meta size : " << hdr.meta_size << "\n";
     std::cout << "      Flags : " << hdr.flags << "\n";
-    std::cout << "   Checksum : " << hdr.checksum << "\n";
+    std::cout << "   Checksum : " << std::hex << hdr.checksum << std::dec << "h (type " << int(hdr.checksum_type) << ")\n";
+}
+
+void dumpCompression(const std::vector<uint8_t>& buf, const BytecodeHeader& hdr) {
+    if(!(hdr.flags & BC_FLAG_COMPRESSED))
+        return;
+
+    std::cout << "\n------ COMPRESSION ------\n";
+
+    auto section = [&](const char* name, uint32_t offset, uint32_t size) {
+        uint32_t raw_size = 0;
+        if(size >= sizeof(raw_size))
+            std::memcpy(&raw_size, buf.data() + offset, sizeof(raw_size));
+
+        std::cout << "  " << name << ": " << size << " / " << raw_size << " bytes";
+        if(raw_size)
+            std::cout << " (" << std::fixed << std::setprecision(1) << 100.0 * size / raw_size << "%)";
+        std::cout << "\n";
+    };
+
+    section("code", hdr.code_offset, hdr.code_size);
+    section("data", hdr.data_offset, hdr.data_size);
+}
+
+void dumpData(const ProgramData& data, const BytecodeHeader& hdr) {
+    if(hdr.data_size == 0)
+        return;
+
+    std::cout << "\n------ CONSTANTS (" << data.const_count << ") ------\n";
+    for(size_t i = 0; i < data.const_count; i++)
+        std::cout << "  $" << i << " = 0x" << std::hex << data.constants[i] << std::dec << " (" << data.constants[i] << ")\n";
+
+    std::cout << "\n------ STATIC DATA (" << data.image_size << " bytes at 0x" << std::hex << data.image_base << ") ------";
+    for(size_t i = 0; i < data.image_size; i++) {
+        if(i % 16 == 0)
+            std::cout << "\n  " << std::setw(8) << std::setfill('0') << data.image_base + i << ":";
+        std::cout << " " << std::setw(2) << std::setfill('0') << int(data.image[i]);
+    }
+    std::cout << std::dec << std::setfill(' ') << "\n";
 }
 
 void dumpMeta(std::ifstream& f, const BytecodeHeader& hdr) {
@@ -90,9 +133,32 @@ int main(int argc, char** argv) {
         BytecodeHeader hdr{};
         f.read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
         dumpHeader(hdr);
+
+        f.seekg(0, std::ios::end);
+        std::vector<uint8_t> buf(f.tellg());
+        f.seekg(0, std::ios::beg);
+        f.read(reinterpret_cast<char*>(buf.data()), buf.size());
+
+        if(!validateHeader(hdr, buf.size()))
+            throw std::runtime_error("Invalid header");
+
+        try {
+            verifyChecksum(buf, hdr);
+            if(hdr.checksum_type != BC_CHECKSUM_NONE)
+                std::cout << "             (valid)\n";
+        } catch(const std::exception& e) {
+            std::cout << "             (" << e.what() << ")\n";
+        }
+
+        dumpCompression(buf, hdr);
+
+        BytecodeHeader unpacked = hdr;
+        unpackSections(buf, unpacked);
+        dumpData(loadData(buf, unpacked), unpacked);
+
         dumpMeta(f, hdr);
     } catch(const std::exception& e) {
-        std::cerr << "Error reading meta: " << e.what() << "\n";
+        std::cerr << "Error reading bytecode: " << e.what() << "\n";
         return 1;
     }
 
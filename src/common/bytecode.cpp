@@ -1,4 +1,6 @@
 #include "bytecode.hpp"
+#include "crc32c.hpp"
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 
@@ -45,10 +47,41 @@ namespace ULang {
         if(hdr.endian > 1)                                      return false;
         if(hdr.code_offset + hdr.code_size > file_size)         return false;
         if(hdr.meta_offset + hdr.meta_size > file_size)         return false;
+        if(hdr.data_offset + hdr.data_size > file_size)         return false;
+
+        // compressed sections are checked once unpacked
+        if(!(hdr.flags & BC_FLAG_COMPRESSED) && hdr.data_size > 0 && 
+           (hdr.data_offset % ULANG_DATA_ALIGN != 0 || hdr.data_size < sizeof(BytecodeDataHeader)))
+            return false;
 
         return true;
     }
 
+    void layoutSections(BytecodeHeader& hdr) {
+        // constants are used in place by the VM, keep them aligned
+        uint32_t hdr_end = sizeof(BytecodeHeader);
+        hdr.data_offset = hdr.data_size ? (hdr_end + ULANG_DATA_ALIGN - 1) / ULANG_DATA_ALIGN * ULANG_DATA_ALIGN : hdr_end;
+
+        hdr.code_offset = hdr.data_offset + hdr.data_size;
+        hdr.meta_offset = hdr.code_offset + hdr.code_size;
+
+        // execution starts at the first instruction
+        hdr.entry_offset = hdr.code_offset;
+    }
+
+    uint32_t bytecodeChecksum(const uint8_t* file, size_t size) {
+        static const uint8_t zero[sizeof(BytecodeHeader::checksum)] = {};
+
+        size_t field = offsetof(BytecodeHeader, checksum);
+        size_t after = field + sizeof(zero);
+        if(size < after)
+            return crc32c(file, size);
+
+        uint32_t crc = crc32c(file, field);
+        crc = crc32c(zero, sizeof(zero), crc);
+        return crc32c(file + after, size - after, crc);
+    }
+
     bool validateMetaSection(const BytecodeHeader& hdr, const BytecodeMetaHeader& meta, size_t file_size) {
         if(hdr.meta_offset + sizeof(BytecodeMetaHeader) > file_size)
             return false;
@@ -87,10 +120,120 @@ namespace ULang {
             case Opcode::RET:   return "RET";
             case Opcode::HALT:  return "HALT";
             case Opcode::MOV:   return "MOV";
+            case Opcode::MEMCPY: return "MEMCPY";
+            case Opcode::MEMSET: return "MEMSET";
+            case Opcode::MEMCMP: return "MEMCMP";
+            case Opcode::IADD32: return "IADD32";
+            case Opcode::ISUB32: return "ISUB32";
+            case Opcode::IMUL32: return "IMUL32";
+            case Opcode::IDIV:   return "IDIV";
+            case Opcode::ADD32:  return "ADD32";
+            case Opcode::SUB32:  return "SUB32";
+            case Opcode::MUL32:  return "MUL32";
+            case Opcode::DIV32:  return "DIV32";
+            case Opcode::IDIV32: return "IDIV32";
+            case Opcode::VLD:    return "VLD";
+            case Opcode::VST:    return "VST";
+            case Opcode::VBCAST: return "VBCAST";
+            case Opcode::VADD:   return "VADD";
+            case Opcode::VSUB:   return "VSUB";
+            case Opcode::VMUL:   return "VMUL";
+            case Opcode::VMIN:   return "VMIN";
+            case Opcode::VMAX:   return "VMAX";
+            case Opcode::VCMPEQ: return "VCMPEQ";
+            case Opcode::VCMPGT: return "VCMPGT";
+            case Opcode::VRSUM:  return "VRSUM";
+            case Opcode::VRMIN:  return "VRMIN";
+            case Opcode::VRMAX:  return "VRMAX";
+            case Opcode::CMP:   return "CMP";
+            case Opcode::TEST:  return "TEST";
+            case Opcode::JNE:   return "JNE";
+            case Opcode::JL:    return "JL";
+            case Opcode::JLE:   return "JLE";
+            case Opcode::JG:    return "JG";
+            case Opcode::JGE:   return "JGE";
+            case Opcode::JB:    return "JB";
+            case Opcode::JBE:   return "JBE";
+            case Opcode::JA:    return "JA";
+            case Opcode::JAE:   return "JAE";
+            case Opcode::BEQZ:  return "BEQZ";
+            case Opcode::BNEZ:  return "BNEZ";
+            case Opcode::BLTZ:  return "BLTZ";
+            case Opcode::BGEZ:  return "BGEZ";
+            case Opcode::BGTZ:  return "BGTZ";
+            case Opcode::BLEZ:  return "BLEZ";
+            case Opcode::PUTC:  return "PUTC";
+            case Opcode::GETC:  return "GETC";
+            case Opcode::OUT:   return "OUT";
+            case Opcode::IN:    return "IN";
+            case Opcode::LD8:   return "LD8";
+            case Opcode::LD16:  return "LD16";
+            case Opcode::LD32:  return "LD32";
+            case Opcode::LD8S:  return "LD8S";
+            case Opcode::LD16S: return "LD16S";
+            case Opcode::LD32S: return "LD32S";
+            case Opcode::ST8:   return "ST8";
+            case Opcode::ST16:  return "ST16";
+            case Opcode::ST32:  return "ST32";
         }
         return "???";
     }
 
+    int branchTargetOperand(Opcode op) {
+        switch(op) {
+            case Opcode::JMP:
+            case Opcode::JZ:
+            case Opcode::JNE:
+            case Opcode::JL:
+            case Opcode::JLE:
+            case Opcode::JG:
+            case Opcode::JGE:
+            case Opcode::JB:
+            case Opcode::JBE:
+            case Opcode::JA:
+            case Opcode::JAE:
+            case Opcode::CALL:
+                return 0;
+
+            case Opcode::BEQZ:
+            case Opcode::BNEZ:
+            case Opcode::BLTZ:
+            case Opcode::BGEZ:
+            case Opcode::BGTZ:
+            case Opcode::BLEZ:
+                return 1;
+
+            default:
+                return -1;
+        }
+    }
+
+    bool isVectorOperand(Opcode op, size_t idx) {
+        switch(op) {
+            case Opcode::VLD:
+            case Opcode::VBCAST:
+                return idx == 0;
+
+            case Opcode::VST:
+            case Opcode::VRSUM:
+            case Opcode::VRMIN:
+            case Opcode::VRMAX:
+                return idx == 1;
+
+            case Opcode::VADD:
+            case Opcode::VSUB:
+            case Opcode::VMUL:
+            case Opcode::VMIN:
+            case Opcode::VMAX:
+            case Opcode::VCMPEQ:
+            case Opcode::VCMPGT:
+                return idx < 2;
+
+            default:
+                return false;
+        }
+    }
+
     const char* operandTypeToStr(OperandType t) {
         switch(t) {
             case OperandType::OP_NULL:      return "null";
@@ -35,13 +35,65 @@ namespace ULang {
         ST = 0x08,
         JMP = 0x09,
         JZ = 0x0A,
+        JE = JZ,
         CALL = 0x0B,
         RET = 0x0C,
         MOV = 0x0E,
+        MEMCPY = 0x10,
+        MEMSET = 0x11,
+        MEMCMP = 0x12,
+        IADD32 = 0x15,
+        ISUB32 = 0x16,
+        IMUL32 = 0x17,
+        IDIV = 0x18,
+        ADD32 = 0x19,
+        SUB32 = 0x1A,
+        MUL32 = 0x1B,
+        DIV32 = 0x1C,
+        IDIV32 = 0x1D,
+        VLD = 0x40,
+        VST = 0x41,
+        VBCAST = 0x42,
+        VADD = 0x43,
+        VSUB = 0x44,
+        VMUL = 0x45,
+        VMIN = 0x46,
+        VMAX = 0x47,
+        VCMPEQ = 0x48,
+        VCMPGT = 0x49,
+        VRSUM = 0x4A,
+        VRMIN = 0x4B,
+        VRMAX = 0x4C,
+        CMP = 0x50,
+        TEST = 0x51,
+        JNE = 0x52,
+        JL = 0x53,
+        JLE = 0x54,
+        JG = 0x55,
+        JGE = 0x56,
+        JB = 0x57,
+        JBE = 0x58,
+        JA = 0x59,
+        JAE = 0x5A,
+        BEQZ = 0x5B,
+        BNEZ = 0x5C,
+        BLTZ = 0x5D,
+        BGEZ = 0x5E,
+        BGTZ = 0x5F,
+        BLEZ = 0x60,
         PUTC = 0x20,
         GETC = 0x21,
         OUT = 0x22,
         IN = 0x23,
+        LD8 = 0x30,
+        LD16 = 0x31,
+        LD32 = 0x32,
+        LD8S = 0x33,
+        LD16S = 0x34,
+        LD32S = 0x35,
+        ST8 = 0x36,
+        ST16 = 0x37,
+        ST32 = 0x38,
         HALT = 0xF0,
     };
 
@@ -163,17 +215,40 @@ namespace ULang {
         uint32_t meta_offset;       ///< Meta section offset
         uint32_t meta_size;         ///< Meta section size
         uint32_t checksum;
-        uint8_t  checksum_type;     ///< Checksum type: 0 = none, 1 = CRC32
+        uint8_t  checksum_type;     ///< Checksum type: BytecodeChecksumType
         uint64_t entry_offset;      ///< Offset of main function (relative to file start)
         uint8_t  reserved[7];
     };
     #pragma pack(pop)
 
+    #pragma pack(push, 1)
+    /**
+     * @brief Data section header, followed by the constant pool and the static data image
+     * 
+     */
+    struct BytecodeDataHeader {
+        uint32_t const_count;       ///< constant pool entries (uint64_t each, 8-byte aligned in file)
+        uint32_t image_base;        ///< heap offset the static data image is loaded at
+        uint32_t image_size;        ///< static data image size in bytes
+        uint32_t reserved;
+    };
+    #pragma pack(pop)
+
+    #define ULANG_DATA_ALIGN 8      ///< alignment of the data section in file
+
     enum BytecodeFlags : uint32_t {
         BC_FLAG_DEBUG      = 1 << 0,
         BC_FLAG_STRIPPED   = 1 << 1,
         BC_FLAG_SIGNED_VM  = 1 << 2,
-        BC_FLAG_OPTIMIZED  = 1 << 3
+        BC_FLAG_OPTIMIZED  = 1 << 3,
+        BC_FLAG_COMPACT    = 1 << 4,    ///< variable-length instructions: opcode, operand type nibbles (A low, B high), LEB128 payloads of non-null operands
+        BC_FLAG_COMPRESSED = 1 << 5     ///< code and data sections are LZ blocks, each prefixed with its uint32_t decompressed size
+    };
+
+    enum BytecodeChecksumType : uint8_t {
+        BC_CHECKSUM_NONE   = 0,
+        BC_CHECKSUM_CRC32  = 1,
+        BC_CHECKSUM_CRC32C = 2     ///< CRC32C of the whole file as stored, with the checksum field zeroed
     };
 
     #pragma pack(push, 1)
@@ -233,6 +308,23 @@ namespace ULang {
      */
     bool validateHeader(const BytecodeHeader& hdr, size_t file_size);
 
+    /**
+     * @brief Sets the section offsets of a header from its section sizes: data (aligned) first, then code, then meta,
+     *        so that constants and the static data image arrive before the code when the file is streamed
+     * 
+     * @param hdr header with code_size, data_size and meta_size filled in
+     */
+    void layoutSections(BytecodeHeader& hdr);
+
+    /**
+     * @brief Computes the BC_CHECKSUM_CRC32C checksum of a bytecode file, the checksum field counts as zero
+     * 
+     * @param file whole file, header included
+     * @param size file size
+     * @return uint32_t checksum
+     */
+    uint32_t bytecodeChecksum(const uint8_t* file, size_t size);
+
     /**
      * @brief Validate metadata structure
      * 
@@ -255,6 +347,27 @@ namespace ULang {
     Instruction parseInstruction(BytecodeStream& stream);
 
     const char* opcodeToStr(Opcode op);
+
+    /**
+     * @brief Gets the operand holding the branch target
+     * 
+     * Branch targets are encoded as offsets into the code section and resolved
+     * to instruction indices when the program is loaded.
+     * 
+     * @param op opcode
+     * @return int operand index, -1 if the opcode does not branch
+     */
+    int branchTargetOperand(Opcode op);
+
+    /**
+     * @brief Checks whether the register operand at index names a vector register
+     * 
+     * @param op opcode
+     * @param idx operand index
+     * @return true if vector register
+     * @return false if scalar register
+     */
+    bool isVectorOperand(Opcode op, size_t idx);
     const char* operandTypeToStr(OperandType t);
 };
 
@@ -0,0 +1,121 @@
+#include "crc32c.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define ULANG_CRC32C_X86
+#endif
+
+#define CRC32C_POLY 0x82F63B78u     ///< reflected Castagnoli polynomial
+
+namespace ULang {
+    struct Crc32cTables {
+        uint32_t t[8][256];
+    };
+
+    static Crc32cTables buildTables() {
+        Crc32cTables tables {};
+
+        for(uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for(int b = 0; b < 8; b++)
+                crc = (crc >> 1) ^ (CRC32C_POLY & (0u - (crc & 1)));
+
+            tables.t[0][i] = crc;
+        }
+
+        // t[k][i] advances t[0][i] by k more zero bytes
+        for(int k = 1; k < 8; k++) {
+            for(uint32_t i = 0; i < 256; i++)
+                tables.t[k][i] = (tables.t[k - 1][i] >> 8) ^ tables.t[0][tables.t[k - 1][i] & 0xFF];
+        }
+
+        return tables;
+    }
+
+    static uint32_t crc32cSlicing8(uint32_t crc, const uint8_t* p, size_t n) {
+        static const Crc32cTables tables = buildTables();
+        const auto& t = tables.t;
+
+        for(; n && (reinterpret_cast<uintptr_t>(p) & 7); n--)
+            crc = t[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+
+        // little-endian words
+        for(; n >= 8; n -= 8, p += 8) {
+            uint64_t w;
+            std::memcpy(&w, p, sizeof(w));
+            w ^= crc;
+
+            crc = t[7][w & 0xFF]         ^ t[6][(w >> 8) & 0xFF]  ^ t[5][(w >> 16) & 0xFF] ^ t[4][(w >> 24) & 0xFF] ^
+                  t[3][(w >> 32) & 0xFF] ^ t[2][(w >> 40) & 0xFF] ^ t[1][(w >> 48) & 0xFF] ^ t[0][w >> 56];
+        }
+
+        for(; n; n--)
+            crc = t[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+
+        return crc;
+    }
+
+#if defined(ULANG_CRC32C_X86) && defined(__GNUC__)
+
+#define ULANG_CRC32C_SSE42
+
+    __attribute__((target("sse4.2")))
+    static uint32_t crc32cSSE42(uint32_t crc, const uint8_t* p, size_t n) {
+        for(; n && (reinterpret_cast<uintptr_t>(p) & 7); n--)
+            crc = _mm_crc32_u8(crc, *p++);
+
+#ifdef __x86_64__
+        uint64_t crc64 = crc;
+        for(; n >= 8; n -= 8, p += 8) {
+            uint64_t w;
+            std::memcpy(&w, p, sizeof(w));
+            crc64 = _mm_crc32_u64(crc64, w);
+        }
+        crc = static_cast<uint32_t>(crc64);
+#endif
+
+        for(; n >= 4; n -= 4, p += 4) {
+            uint32_t w;
+            std::memcpy(&w, p, sizeof(w));
+            crc = _mm_crc32_u32(crc, w);
+        }
+
+        for(; n; n--)
+            crc = _mm_crc32_u8(crc, *p++);
+
+        return crc;
+    }
+
+#endif
+
+    typedef uint32_t (*Crc32cFn)(uint32_t crc, const uint8_t* p, size_t n);
+
+    struct Crc32cImpl {
+        Crc32cFn fn;
+        const char* name;
+    };
+
+    static Crc32cImpl selectImpl() {
+#ifdef ULANG_CRC32C_SSE42
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("sse4.2"))
+            return {crc32cSSE42, "sse4.2"};
+#endif
+
+        return {crc32cSlicing8, "slicing-by-8"};
+    }
+
+    static const Crc32cImpl& impl() {
+        static const Crc32cImpl selected = selectImpl();
+        return selected;
+    }
+
+    uint32_t crc32c(const uint8_t* data, size_t size, uint32_t crc) {
+        return ~impl().fn(~crc, data, size);
+    }
+
+    const char* crc32cImpl() {
+        return impl().name;
+    }
+};
@@ -0,0 +1,25 @@
+#ifndef __ULANG_COM_CRC32C_H
+#define __ULANG_COM_CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ULang {
+    /**
+     * @brief Computes CRC32C (Castagnoli), using the SSE4.2 crc32 instruction when the CPU has it
+     *        and slicing-by-8 tables otherwise
+     * 
+     * @param data data
+     * @param size data size
+     * @param crc result of the previous chunk to continue from, 0 to start
+     * @return uint32_t checksum
+     */
+    uint32_t crc32c(const uint8_t* data, size_t size, uint32_t crc = 0);
+
+    /**
+     * @brief Name of the implementation crc32c() dispatches to ("sse4.2" or "slicing-by-8")
+     */
+    const char* crc32cImpl();
+};
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef __ULANG_COM_KEYWORDS_H
+#define __ULANG_COM_KEYWORDS_H
+
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#define ULANG_KEYWORD_SLOTS 32      ///< perfect hash table size, power of two
+
+namespace ULang {
+    enum class Keyword : uint8_t {
+        NONE,       ///< empty slot
+        FUNCTION,   ///< fn
+        RETURN,     ///< return
+        TYPE        ///< builtin type name
+    };
+
+    struct KeywordEntry {
+        std::string_view name;
+        Keyword keyword = Keyword::NONE;
+        const DataType* type = nullptr;     ///< builtin type, Keyword::TYPE only
+    };
+
+    inline constexpr KeywordEntry keyword_list[] = {
+        {"fn",      Keyword::FUNCTION,  nullptr},
+        {"return",  Keyword::RETURN,    nullptr},
+
+        {"int8",    Keyword::TYPE,      &TYPE_INT8},
+        {"int16",   Keyword::TYPE,      &TYPE_INT16},
+        {"int32",   Keyword::TYPE,      &TYPE_INT32},
+        {"int64",   Keyword::TYPE,      &TYPE_INT64},
+
+        {"uint8",   Keyword::TYPE,      &TYPE_UINT8},
+        {"uint16",  Keyword::TYPE,      &TYPE_UINT16},
+        {"uint32",  Keyword::TYPE,      &TYPE_UINT32},
+        {"uint64",  Keyword::TYPE,      &TYPE_UINT64},
+
+        {"char",    Keyword::TYPE,      &TYPE_CHAR},
+        {"void",    Keyword::TYPE,      &TYPE_VOID},
+    };
+
+    /**
+     * @brief FNV-1a with a seeded offset basis, reduced to a table slot
+     */
+    constexpr uint32_t keywordHash(std::string_view str, uint32_t seed) {
+        uint32_t h = 2166136261u ^ seed;
+        for(char c: str) {
+            h ^= static_cast<uint8_t>(c);
+            h *= 16777619u;
+        }
+
+        return (h ^ (h >> 15)) & (ULANG_KEYWORD_SLOTS - 1);
+    }
+
+    struct KeywordTable {
+        uint32_t seed = 0;
+        KeywordEntry slots[ULANG_KEYWORD_SLOTS] {};
+    };
+
+    /**
+     * @brief Finds the first seed that maps every keyword to its own slot and fills the table with it
+     */
+    constexpr KeywordTable buildKeywordTable() {
+        for(uint32_t seed = 0; seed < 0x10000; seed++) {
+            KeywordTable table {};
+            table.seed = seed;
+
+            bool collision = false;
+            for(const KeywordEntry& kw: keyword_list) {
+                KeywordEntry& slot = table.slots[keywordHash(kw.name, seed)];
+                if(slot.keyword != Keyword::NONE) {
+                    collision = true;
+                    break;
+                }
+
+                slot = kw;
+            }
+
+            if(!collision)
+                return table;
+        }
+
+        return KeywordTable {};
+    }
+
+    inline constexpr KeywordTable keyword_table = buildKeywordTable();
+
+    constexpr bool keywordTableComplete() {
+        for(const KeywordEntry& kw: keyword_list) {
+            if(keyword_table.slots[keywordHash(kw.name, keyword_table.seed)].name != kw.name)
+                return false;
+        }
+
+        return true;
+    }
+
+    static_assert(keywordTableComplete(), "no perfect hash seed for the keyword table, grow ULANG_KEYWORD_SLOTS");
+
+    /**
+     * @brief Looks up a keyword or builtin type name with a single hash and compare
+     * @return const KeywordEntry* entry, nullptr for ordinary identifiers
+     */
+    constexpr const KeywordEntry* lookupKeyword(std::string_view str) {
+        const KeywordEntry& slot = keyword_table.slots[keywordHash(str, keyword_table.seed)];
+        return slot.keyword != Keyword::NONE && slot.name == str ? &slot : nullptr;
+    }
+};
+
+#endif
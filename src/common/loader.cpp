@@ -0,0 +1,290 @@
+#include "loader.hpp"
+#include "lz.hpp"
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace ULang {
+    static uint32_t readVarint(const std::vector<uint8_t>& buf, size_t& pc, size_t instr_offset) {
+        uint32_t val = 0;
+
+        for(int shift = 0; shift < 35; shift += 7) {
+            if(pc >= buf.size())
+                throw std::runtime_error("Bytecode truncated: incomplete instruction at offset " + std::to_string(instr_offset));
+
+            uint8_t byte = buf[pc++];
+
+            // the 5th byte only has room for the top 4 bits, and no continuation
+            if(shift == 28 && byte > 0x0F)
+                break;
+
+            val |= uint32_t(byte & 0x7F) << shift;
+
+            if(!(byte & 0x80))
+                return val;
+        }
+
+        throw std::runtime_error("Malformed operand of instruction at offset " + std::to_string(instr_offset));
+    }
+
+    static Instruction readInstructionCompact(const std::vector<uint8_t>& buf, size_t& pc) {
+        Instruction instr {};
+        instr.offset = pc;
+
+        if(pc + 2 > buf.size())
+            throw std::runtime_error("Bytecode truncated: incomplete instruction at offset " + std::to_string(pc));
+
+        instr.opcode = static_cast<Opcode>(buf[pc++]);
+        uint8_t types = buf[pc++];
+
+        for(uint8_t i = 0; i < ULANG_OP_COUNT; ++i) {
+            Operand op{};
+            op.type = static_cast<OperandType>((types >> (4 * i)) & 0x0F);
+            op.data = op.type == OperandType::OP_NULL ? 0 : readVarint(buf, pc, instr.offset);
+
+            instr.operands.push_back(op);
+        }
+
+        return instr;
+    }
+
+    Instruction readInstruction(const std::vector<uint8_t>& buf, size_t& pc, bool compact) {
+        if(compact)
+            return readInstructionCompact(buf, pc);
+
+        Instruction instr {};
+        instr.offset = pc;
+
+        if(pc + instr.calcTotalSz() > buf.size())
+            throw std::runtime_error("Bytecode truncated: incomplete instruction at offset " + std::to_string(pc));
+
+        instr.opcode = static_cast<Opcode>(buf[pc++]);
+
+        for(uint8_t i = 0; i < ULANG_OP_COUNT; ++i) {
+            Operand op{};
+            op.type = static_cast<OperandType>(buf[pc++]);
+            op.data = 0;
+
+            for(int b = 0; b < 4; b++)
+                op.data |= uint32_t(buf[pc++]) << (8 * b);
+
+            instr.operands.push_back(op);
+        }
+
+        return instr;
+    }
+
+    void verifyChecksum(const std::vector<uint8_t>& buf, const BytecodeHeader& hdr) {
+        switch(hdr.checksum_type) {
+            case BC_CHECKSUM_NONE:
+                return;
+
+            case BC_CHECKSUM_CRC32C:
+                if(bytecodeChecksum(buf.data(), buf.size()) != hdr.checksum)
+                    throw std::runtime_error("Checksum mismatch: bytecode file is corrupted");
+                return;
+
+            default:
+                throw std::runtime_error("Unsupported checksum type " + std::to_string(hdr.checksum_type));
+        }
+    }
+
+    static uint32_t sectionRawSize(const std::vector<uint8_t>& buf, uint32_t offset, uint32_t size) {
+        uint32_t raw_size = 0;
+        if(size == 0)
+            return 0;
+
+        if(size < sizeof(raw_size))
+            throw std::runtime_error("Bytecode truncated: compressed section incomplete");
+
+        std::memcpy(&raw_size, buf.data() + offset, sizeof(raw_size));
+
+        // a block can't expand more than this, don't let a corrupted prefix allocate gigabytes
+        if(raw_size > uint64_t(size) * 255)
+            throw std::runtime_error("Compressed section size out of range");
+
+        return raw_size;
+    }
+
+    void unpackSections(std::vector<uint8_t>& buf, BytecodeHeader& hdr) {
+        if(!(hdr.flags & BC_FLAG_COMPRESSED))
+            return;
+
+        uint32_t code_raw = sectionRawSize(buf, hdr.code_offset, hdr.code_size);
+        uint32_t data_raw = sectionRawSize(buf, hdr.data_offset, hdr.data_size);
+
+        BytecodeHeader out_hdr = hdr;
+        out_hdr.flags &= ~BC_FLAG_COMPRESSED;
+        out_hdr.checksum = 0;   // covers the stored file only
+        out_hdr.checksum_type = BC_CHECKSUM_NONE;
+        out_hdr.code_size = code_raw;
+        out_hdr.data_size = data_raw;
+        layoutSections(out_hdr);
+
+        std::vector<uint8_t> out(size_t(out_hdr.meta_offset) + out_hdr.meta_size, 0);
+        std::memcpy(out.data(), &out_hdr, sizeof(out_hdr));
+
+        if(code_raw)
+            lzDecompress(buf.data() + hdr.code_offset + sizeof(uint32_t), hdr.code_size - sizeof(uint32_t), out.data() + out_hdr.code_offset, code_raw);
+        if(data_raw)
+            lzDecompress(buf.data() + hdr.data_offset + sizeof(uint32_t), hdr.data_size - sizeof(uint32_t), out.data() + out_hdr.data_offset, data_raw);
+
+        std::memcpy(out.data() + out_hdr.meta_offset, buf.data() + hdr.meta_offset, hdr.meta_size);
+
+        if(!validateHeader(out_hdr, out.size()))
+            throw std::runtime_error("Invalid header of the unpacked bytecode");
+
+        buf.swap(out);
+        hdr = out_hdr;
+    }
+
+    static void throwInvalidTarget(const Instruction& instr) {
+        throw std::runtime_error(std::string("Invalid branch target of ") + opcodeToStr(instr.opcode) + 
+                                 " at offset " + std::to_string(instr.offset));
+    }
+
+    // compact code has to be walked from the start to find the instruction boundaries
+    static std::vector<Instruction> loadProgramCompact(const std::vector<uint8_t>& buf, const BytecodeHeader& hdr) {
+        std::vector<Instruction> program;
+        std::unordered_map<size_t, uint32_t> index_of;  ///< code offset -> instruction index
+
+        size_t pc = hdr.code_offset;
+        size_t end = hdr.code_offset + hdr.code_size;
+
+        while(pc < end) {
+            index_of[pc - hdr.code_offset] = program.size();
+            program.push_back(readInstruction(buf, pc, true));
+        }
+
+        if(pc != end)
+            throw std::runtime_error("Bytecode truncated: last instruction crosses the end of code");
+
+        // the end of code is a valid target too (falls off the program)
+        index_of[hdr.code_size] = program.size();
+
+        for(Instruction& instr: program) {
+            int op_no = branchTargetOperand(instr.opcode);
+            if(op_no < 0)
+                continue;
+
+            Operand& target = instr.operands[op_no];
+
+            auto it = index_of.find(target.data);
+            if(target.type != OperandType::OP_IMMEDIATE || it == index_of.end())
+                throwInvalidTarget(instr);
+
+            target.data = it->second;
+        }
+
+        return program;
+    }
+
+    void decodeProgramRange(const std::vector<uint8_t>& buf, const BytecodeHeader& hdr, std::vector<Instruction>& program, size_t begin, size_t end) {
+        const size_t instr_size = Instruction{}.calcTotalSz();
+
+        for(size_t i = begin; i < end; i++) {
+            size_t pc = hdr.code_offset + i * instr_size;
+            Instruction& instr = program[i];
+            instr = readInstruction(buf, pc, false);
+
+            int op_no = branchTargetOperand(instr.opcode);
+            if(op_no < 0)
+                continue;
+
+            Operand& target = instr.operands[op_no];
+
+            // the end of code is a valid target too (falls off the program)
+            if(target.type != OperandType::OP_IMMEDIATE || target.data % instr_size != 0 || target.data / instr_size > program.size())
+                throwInvalidTarget(instr);
+
+            target.data /= instr_size;
+        }
+    }
+
+    static std::vector<Instruction> loadProgramFixed(const std::vector<uint8_t>& buf, const BytecodeHeader& hdr) {
+        const size_t instr_size = Instruction{}.calcTotalSz();
+        if(hdr.code_size % instr_size != 0)
+            throw std::runtime_error("Bytecode truncated: last instruction crosses the end of code");
+
+        std::vector<Instruction> program(hdr.code_size / instr_size);
+
+        size_t threads = 1;
+        if(hdr.code_size >= ULANG_PARALLEL_DECODE_MIN)
+            threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), hdr.code_size / (ULANG_PARALLEL_DECODE_MIN / 4));
+
+        if(threads <= 1) {
+            decodeProgramRange(buf, hdr, program, 0, program.size());
+            return program;
+        }
+
+        std::vector<std::thread> workers;
+        std::vector<std::exception_ptr> errors(threads);
+        size_t chunk = (program.size() + threads - 1) / threads;
+
+        for(size_t t = 0; t < threads; t++) {
+            size_t begin = std::min(program.size(), t * chunk);
+            size_t end = std::min(program.size(), begin + chunk);
+
+            workers.emplace_back([&, t, begin, end]() {
+                try {
+                    decodeProgramRange(buf, hdr, program, begin, end);
+                } catch(...) {
+                    errors[t] = std::current_exception();
+                }
+            });
+        }
+
+        for(std::thread& worker: workers)
+            worker.join();
+
+        // report the first error in program order, like the sequential path would
+        for(std::exception_ptr& error: errors) {
+            if(error)
+                std::rethrow_exception(error);
+        }
+
+        return program;
+    }
+
+    std::vector<Instruction> loadProgram(const std::vector<uint8_t>& buf, const BytecodeHeader& hdr) {
+        if(hdr.flags & BC_FLAG_COMPACT)
+            return loadProgramCompact(buf, hdr);
+
+        return loadProgramFixed(buf, hdr);
+    }
+
+    ProgramData loadData(const std::vector<uint8_t>& buf, const BytecodeHeader& hdr) {
+        ProgramData data;
+        if(hdr.data_size == 0)
+            return data;
+
+        BytecodeDataHeader data_hdr {};
+        std::memcpy(&data_hdr, buf.data() + hdr.data_offset, sizeof(BytecodeDataHeader));
+
+        size_t pool_offset = hdr.data_offset + sizeof(BytecodeDataHeader);
+        if(sizeof(BytecodeDataHeader) + size_t(data_hdr.const_count) * sizeof(uint64_t) > hdr.data_size)
+            throw std::runtime_error("Bytecode truncated: constant pool incomplete");
+
+        // entries are used in place
+        const uint8_t* pool = buf.data() + pool_offset;
+        if(reinterpret_cast<uintptr_t>(pool) % alignof(uint64_t) != 0)
+            throw std::runtime_error("Constant pool not aligned");
+
+        data.constants = reinterpret_cast<const uint64_t*>(pool);
+        data.const_count = data_hdr.const_count;
+
+        size_t image_offset = sizeof(BytecodeDataHeader) + size_t(data_hdr.const_count) * sizeof(uint64_t);
+        if(image_offset + data_hdr.image_size > hdr.data_size)
+            throw std::runtime_error("Bytecode truncated: static data image incomplete");
+
+        data.image = data_hdr.image_size ? buf.data() + hdr.data_offset + image_offset : nullptr;
+        data.image_base = data_hdr.image_base;
+        data.image_size = data_hdr.image_size;
+
+        return data;
+    }
+};
@@ -0,0 +1,101 @@
+#ifndef __ULANG_COM_LOADER_H
+#define __ULANG_COM_LOADER_H
+
+#include "bytecode.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Fixed-size code sections at least this big (in bytes) are decoded on multiple threads
+#ifndef ULANG_PARALLEL_DECODE_MIN
+#define ULANG_PARALLEL_DECODE_MIN (4 * 1024 * 1024)
+#endif
+
+namespace ULang {
+    /**
+     * @brief View into the data section of a loaded bytecode file, nothing is copied so the file buffer must outlive it
+     */
+    struct ProgramData {
+        const uint64_t* constants = nullptr;    ///< constant pool
+        uint32_t const_count = 0;
+
+        const uint8_t* image = nullptr;         ///< pre-initialized globals, copied to the heap at image_base
+        uint32_t image_base = 0;
+        uint32_t image_size = 0;
+    };
+
+    /**
+     * @brief Decodes a single instruction at pc and moves pc past it
+     * 
+     * @exception std::runtime_error if the instruction is truncated or malformed
+     * 
+     * @param buf bytecode file
+     * @param pc file offset of the instruction
+     * @param compact whether the code uses the variable-length encoding (BC_FLAG_COMPACT)
+     * @return Instruction 
+     */
+    Instruction readInstruction(const std::vector<uint8_t>& buf, size_t& pc, bool compact = false);
+
+    /**
+     * @brief Checks the integrity of the whole file against the header checksum, files without a checksum pass
+     * 
+     * @exception std::runtime_error on mismatch or an unsupported checksum type
+     * 
+     * @param buf bytecode file as stored
+     * @param hdr validated header
+     */
+    void verifyChecksum(const std::vector<uint8_t>& buf, const BytecodeHeader& hdr);
+
+    /**
+     * @brief Decompresses the code and data sections of a BC_FLAG_COMPRESSED file into a plain image,
+     *        updating the header in buf as well; files that are not compressed are left alone
+     *
+     * The whole image is unpacked before loadProgram() decodes it, so a compressed file costs a second
+     * buffer and pass, and ProgramStream does not stream it.
+     * 
+     * @exception std::runtime_error if a section is corrupted
+     * 
+     * @param buf bytecode file, replaced by the unpacked one
+     * @param hdr validated header, updated to the unpacked layout
+     */
+    void unpackSections(std::vector<uint8_t>& buf, BytecodeHeader& hdr);
+
+    /**
+     * @brief Decodes the code section and resolves branch targets from code section offsets to instruction indices,
+     *        fixed-size code of at least ULANG_PARALLEL_DECODE_MIN bytes is split into chunks decoded in parallel
+     * 
+     * @exception std::runtime_error if the code is truncated or a branch target is not an instruction boundary
+     * 
+     * @param buf bytecode file
+     * @param hdr validated header
+     * @return std::vector<Instruction> program ready to be executed
+     */
+    std::vector<Instruction> loadProgram(const std::vector<uint8_t>& buf, const BytecodeHeader& hdr);
+
+    /**
+     * @brief Decodes instructions [begin, end) of fixed-size code in place, resolving their branch targets;
+     *        instruction i is at i * size and targets resolve by division, so any range can be decoded on its own
+     * 
+     * @exception std::runtime_error if an instruction is truncated or a branch target is not an instruction boundary
+     * 
+     * @param buf bytecode file, only the bytes of the range have to be present
+     * @param hdr validated header of code without BC_FLAG_COMPACT
+     * @param program program already sized to the instruction count of the code section
+     * @param begin first instruction index
+     * @param end instruction index past the range
+     */
+    void decodeProgramRange(const std::vector<uint8_t>& buf, const BytecodeHeader& hdr, std::vector<Instruction>& program, size_t begin, size_t end);
+
+    /**
+     * @brief Maps the data section of the bytecode file
+     * 
+     * @exception std::runtime_error if the data section is malformed
+     * 
+     * @param buf bytecode file
+     * @param hdr validated header
+     * @return ProgramData view into buf
+     */
+    ProgramData loadData(const std::vector<uint8_t>& buf, const BytecodeHeader& hdr);
+};
+
+#endif
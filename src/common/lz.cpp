@@ -0,0 +1,148 @@
+#include "lz.hpp"
+#include <cstring>
+#include <stdexcept>
+
+#define LZ_MIN_MATCH        4
+#define LZ_HASH_BITS        12
+#define LZ_MAX_OFFSET       0xFFFF
+#define LZ_LAST_LITERALS    5       ///< the block always ends with this many literals
+#define LZ_MF_LIMIT         12      ///< no match starts this close to the end
+
+namespace ULang {
+    static inline uint32_t read32(const uint8_t* p) {
+        uint32_t val;
+        std::memcpy(&val, p, sizeof(val));
+        return val;
+    }
+
+    static inline uint32_t hash32(uint32_t seq) {
+        return (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+    }
+
+    static void writeLength(std::vector<uint8_t>& out, size_t len) {
+        for(; len >= 255; len -= 255)
+            out.push_back(255);
+
+        out.push_back(uint8_t(len));
+    }
+
+    static void writeSequence(std::vector<uint8_t>& out, const uint8_t* lit, size_t lit_len, size_t match_len, size_t offset) {
+        size_t match_code = match_len ? match_len - LZ_MIN_MATCH : 0;
+
+        out.push_back(uint8_t(((lit_len < 15 ? lit_len : 15) << 4) | (match_code < 15 ? match_code : 15)));
+        if(lit_len >= 15)
+            writeLength(out, lit_len - 15);
+
+        out.insert(out.end(), lit, lit + lit_len);
+
+        // last sequence
+        if(!match_len)
+            return;
+
+        out.push_back(uint8_t(offset & 0xFF));
+        out.push_back(uint8_t((offset >> 8) & 0xFF));
+
+        if(match_code >= 15)
+            writeLength(out, match_code - 15);
+    }
+
+    std::vector<uint8_t> lzCompress(const uint8_t* src, size_t size) {
+        std::vector<uint8_t> out;
+        out.reserve(size / 2 + 16);
+
+        std::vector<size_t> table(size_t(1) << LZ_HASH_BITS, SIZE_MAX);  ///< hash -> last position
+        size_t anchor = 0;
+        size_t i = 0;
+
+        while(size >= LZ_MF_LIMIT && i <= size - LZ_MF_LIMIT) {
+            uint32_t seq = read32(src + i);
+            uint32_t h = hash32(seq);
+
+            size_t cand = table[h];
+            table[h] = i;
+
+            if(cand == SIZE_MAX || i - cand > LZ_MAX_OFFSET || read32(src + cand) != seq) {
+                i++;
+                continue;
+            }
+
+            size_t len = LZ_MIN_MATCH;
+            while(i + len < size - LZ_LAST_LITERALS && src[cand + len] == src[i + len])
+                len++;
+
+            writeSequence(out, src + anchor, i - anchor, len, i - cand);
+
+            i += len;
+            anchor = i;
+        }
+
+        writeSequence(out, src + anchor, size - anchor, 0, 0);
+        return out;
+    }
+
+    static size_t readLength(const uint8_t*& ip, const uint8_t* end) {
+        size_t len = 0;
+        uint8_t byte;
+
+        do {
+            if(ip >= end)
+                throw std::runtime_error("Corrupted compressed section: truncated length");
+
+            byte = *ip++;
+            len += byte;
+        } while(byte == 255);
+
+        return len;
+    }
+
+    void lzDecompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dst_size) {
+        const uint8_t* ip = src;
+        const uint8_t* end = src + size;
+        size_t op = 0;
+
+        while(ip < end) {
+            uint8_t token = *ip++;
+
+            size_t lit_len = token >> 4;
+            if(lit_len == 15)
+                lit_len += readLength(ip, end);
+
+            if(lit_len > size_t(end - ip) || lit_len > dst_size - op)
+                throw std::runtime_error("Corrupted compressed section: literals out of bounds");
+
+            std::memcpy(dst + op, ip, lit_len);
+            ip += lit_len;
+            op += lit_len;
+
+            // last sequence
+            if(ip == end)
+                break;
+
+            if(end - ip < 2)
+                throw std::runtime_error("Corrupted compressed section: truncated offset");
+
+            size_t offset = ip[0] | (size_t(ip[1]) << 8);
+            ip += 2;
+
+            if(offset == 0 || offset > op)
+                throw std::runtime_error("Corrupted compressed section: invalid match offset");
+
+            size_t match_len = token & 0x0F;
+            if(match_len == 15)
+                match_len += readLength(ip, end);
+            match_len += LZ_MIN_MATCH;
+
+            if(match_len > dst_size - op)
+                throw std::runtime_error("Corrupted compressed section: match out of bounds");
+
+            // matches may overlap their own output
+            const uint8_t* from = dst + op - offset;
+            for(size_t k = 0; k < match_len; k++)
+                dst[op + k] = from[k];
+            op += match_len;
+        }
+
+        if(op != dst_size)
+            throw std::runtime_error("Corrupted compressed section: size mismatch");
+    }
+};
@@ -0,0 +1,34 @@
+#ifndef __ULANG_COM_LZ_H
+#define __ULANG_COM_LZ_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ULang {
+    /**
+     * @brief Compresses a buffer into an LZ4-style block
+     *
+     * The block is a sequence of tokens (literal length in the high nibble, match length - 4 in the low one),
+     * 255-byte extended lengths, literals and 16-bit little-endian match offsets. The last sequence holds literals only.
+     *
+     * @param src data
+     * @param size data size
+     * @return std::vector<uint8_t> compressed block
+     */
+    std::vector<uint8_t> lzCompress(const uint8_t* src, size_t size);
+
+    /**
+     * @brief Decompresses an LZ4-style block straight into its destination
+     *
+     * @exception std::runtime_error if the block is corrupted or does not decompress to exactly dst_size bytes
+     *
+     * @param src compressed block
+     * @param size compressed block size
+     * @param dst destination
+     * @param dst_size decompressed size
+     */
+    void lzDecompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dst_size);
+};
+
+#endif
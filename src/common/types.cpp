@@ -1,23 +1,18 @@
 #include "types.hpp"
+#include "keywords.hpp"
 #include <stdexcept>
 
 namespace ULang {
-    const ULang::DataType* resolveDataType(const std::string& typeName) {
-        using namespace ULang;
-
-        if(typeName == "int8")   return &TYPE_INT8;
-        if(typeName == "int16")  return &TYPE_INT16;
-        if(typeName == "int32")  return &TYPE_INT32;
-        if(typeName == "int64")  return &TYPE_INT64;
-
-        if(typeName == "uint8")  return &TYPE_UINT8;
-        if(typeName == "uint16") return &TYPE_UINT16;
-        if(typeName == "uint32") return &TYPE_UINT32;
-        if(typeName == "uint64") return &TYPE_UINT64;
+    const ULang::DataType* findDataType(std::string_view typeName) {
+        const KeywordEntry* kw = lookupKeyword(typeName);
+        return kw && kw->keyword == Keyword::TYPE ? kw->type : nullptr;
+    }
 
-        if(typeName == "char")   return &TYPE_CHAR;
-        if(typeName == "void")   return &TYPE_VOID;
+    const ULang::DataType* resolveDataType(std::string_view typeName) {
+        const DataType* type = findDataType(typeName);
+        if(type == nullptr)
+            throw std::runtime_error("could not resolve type: " + std::string(typeName));
 
-        throw std::runtime_error("could not resolve type: " + typeName);
+        return type;
     }
 };
@@ -6,6 +6,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace ULang {
     enum class DataTypeKind {
@@ -28,7 +29,17 @@ namespace ULang {
         DataTypeKind kind;
     };
 
-    const ULang::DataType* resolveDataType(const std::string& typeName);
+    /**
+     * @brief Looks up a builtin type by name
+     * @return const ULang::DataType* type, nullptr if there is no such type
+     */
+    const ULang::DataType* findDataType(std::string_view typeName);
+
+    /**
+     * @brief Looks up a builtin type by name
+     * @exception std::runtime_error if there is no such type
+     */
+    const ULang::DataType* resolveDataType(std::string_view typeName);
 
 #define _FLAGS_UINT (DataTypeFlags::INTEGRAL | DataTypeFlags::NUMERIC)
 #define _FLAGS_INT  (DataTypeFlags::SIGN | _FLAGS_UINT)
@@ -38,6 +38,8 @@ namespace ULang {
 
 
     {0x15, "FNR"},
+    {0x16, "CNT"},      ///< byte count of bulk memory operations
+    {0x17, "VTYPE"},    ///< vector lane width/signedness/length (see vm/simd.hpp)
     };
 };
 
@@ -57,8 +59,11 @@ namespace ULang {
 #define R_FP    vmreg_defines[13]
 #define R_PC    vmreg_defines[14]
 #define R_FLAGS vmreg_defines[15]
-#define R_TMP0  vmreg_defines[16]
-#define R_TMP1  vmreg_defines[17]
-#define R_TMP2  vmreg_defines[18]
-#define R_TMP3  vmreg_defines[19]
-#define R_FNR   vmreg_defines[20]
+#define R_IP    vmreg_defines[16]
+#define R_TMP0  vmreg_defines[17]
+#define R_TMP1  vmreg_defines[18]
+#define R_TMP2  vmreg_defines[19]
+#define R_TMP3  vmreg_defines[20]
+#define R_FNR   vmreg_defines[21]
+#define R_CNT   vmreg_defines[22]
+#define R_VTYPE vmreg_defines[23]
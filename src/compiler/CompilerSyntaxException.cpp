@@ -70,7 +70,7 @@ namespace ULang {
             out.append("\033[0m");
 
         out.append(" | ");
-        out.append(this->loc.loc_file + "@" + std::to_string(this->loc.loc_line) + ":" + std::to_string(this->loc.loc_col));
+        out.append(sourceFileName(this->loc.loc_file) + "@" + std::to_string(this->loc.loc_line) + ":" + std::to_string(this->loc.loc_col));
         out.append(" " + this->msg + " ");
 
         if(this->errnum != 0)
@@ -106,7 +106,7 @@ namespace ULang {
 
         out.append("{");
 
-        out.append("\"file\": \"" + this->loc.loc_file + "\",");
+        out.append("\"file\": \"" + sourceFileName(this->loc.loc_file) + "\",");
         out.append("\"line\": " + std::to_string(this->loc.loc_line) + ",");
         out.append("\"column\": " + std::to_string(this->loc.loc_col) + ",");
 
@@ -4,15 +4,32 @@
 #include <vector>
 
 namespace ULang {
-    ASTNode::ASTNode(int64_t val)
+    ASTNode::ASTNode(uint64_t val)
     : type(ASTNodeType::NUMBER), val(val) {}
 
-    ASTNode::ASTNode(const std::string& varname)
-    : type(ASTNodeType::VARIABLE), name(varname) {}
-
     ASTNode::ASTNode(ASTNodeType t)
     : type(t) {}
 
+    const std::string& ASTNode::name() const {
+        static const std::string unnamed;
+        return this->symbol ? this->symbol->name : unnamed;
+    }
+
+    ASTList::iterator& ASTList::iterator::operator++() {
+        this->node = this->node->next;
+        return *this;
+    }
+
+    void ASTList::push(ASTNode* node) {
+        node->next = nullptr;
+
+        if(this->last)
+            this->last->next = node;
+        else this->first = node;
+
+        this->last = node;
+    }
+
     /*
     ASTNode* parsePrimary(const std::vector<Token>& tokens, size_t& pos) {
         if(tokens[pos].type == TokenType::Number) {
@@ -1,4 +1,7 @@
 #include "compiler.hpp"
+#include "compiler/ir.hpp"
+#include <utility>
+#include <vector>
 
 namespace ULang {
     bool isBinop(TokenType tt) {
@@ -15,4 +18,47 @@ namespace ULang {
 
         return left;
     }
+
+    bool CompilerInstance::foldConstant(ASTNode* node, uint64_t& out) {
+        if(!node)
+            return false;
+
+        // post-order evaluation on explicit stacks, expressions may be arbitrarily deep
+        std::vector<std::pair<ASTNode*, bool>> stack = {{node, false}};
+        std::vector<uint64_t> values;
+
+        while(!stack.empty()) {
+            auto [n, children_done] = stack.back();
+            stack.pop_back();
+
+            if(n->type == ASTNodeType::NUMBER) {
+                values.push_back(n->val);
+                continue;
+            }
+
+            if(n->type != ASTNodeType::BINOP)
+                return false;
+
+            if(!children_done) {
+                stack.push_back({n, true});
+                stack.push_back({n->righthand, false});
+                stack.push_back({n->lefthand, false});
+                continue;
+            }
+
+            uint64_t R = values.back(); values.pop_back();
+            uint64_t L = values.back(); values.pop_back();
+
+            // the opcode the node compiles to, so the image holds what the code would have stored;
+            // divisions by zero and overflowing ones are left for the runtime, so that they get reported
+            uint64_t val;
+            if(!evalBinop(binopOpcode(n->op, n->value_type), L, R, val))
+                return false;
+
+            values.push_back(val);
+        }
+
+        out = values.back();
+        return true;
+    }
 };
\ No newline at end of file
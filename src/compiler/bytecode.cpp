@@ -1,6 +1,8 @@
 #include "bytecode.hpp"
 #include "compiler.hpp"
 #include "types.hpp"
+#include "lz.hpp"
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <algorithm>
@@ -8,7 +10,7 @@
 #include <iostream>
 
 namespace ULang {
-    BytecodeHeader buildBytecodeHeader(uint32_t code_size, uint32_t meta_size, uint8_t word_size) {
+    BytecodeHeader buildBytecodeHeader(uint32_t code_size, uint32_t data_size, uint32_t meta_size, uint8_t word_size, uint32_t flags) {
         BytecodeHeader hdr{};
         std::memcpy(hdr.magic, "ULANG0", 6);
         
@@ -18,19 +20,20 @@ namespace ULang {
         hdr.endian = 0;             // little-endian
         hdr.word_size = word_size;  // 32-bit
 
-        hdr.code_offset = sizeof(BytecodeHeader);
         hdr.code_size = code_size;
-        hdr.meta_offset = hdr.code_offset + hdr.code_size;
-        hdr.meta_size   = sizeof(BytecodeMetaHeader);
+        hdr.data_size = data_size;
+        hdr.meta_size = meta_size;
+        layoutSections(hdr);
 
-        hdr.flags = 0;
-        hdr.checksum = 0;    // TODO: CRC32
+        hdr.flags = flags;
+        hdr.checksum = 0;    // filled in by writeBytecode once the file is complete
+        hdr.checksum_type = BC_CHECKSUM_CRC32C;
 
         return hdr;
     }
 
-    MetaData buildMeta(SymbolTable& symtable, const std::vector<const DataType*>& types, bool verbose_en) {
-#define verbose_cout if(verbose_en) std::cout
+    MetaData buildMeta(SymbolTable& symtable, const std::vector<const DataType*>& types, const std::vector<uint32_t>& code_offsets, uint32_t code_offset, bool verbose_en) {
+#define verbose_cout if(ULANG_TRACE_ENABLED && verbose_en) std::cout
         MetaData meta;
 
         verbose_cout << "----- Building meta header -----" << std::endl;
@@ -52,51 +55,101 @@ namespace ULang {
         Scope* scope = symtable.getGlobalScope();
         // TODO: iterate through all scopes
 
-        for(auto& [name, sym] : scope->symbols) {
+        for(const Symbol* sym: scope->symbols) {
             MetaSymbol msym;
-            msym.name_offset = addStringToPool(meta.string_pool, name);
+            msym.name_offset = addStringToPool(meta.string_pool, sym->name);
 
-            auto it = std::find(types.begin(), types.end(), sym.type);
+            auto it = std::find(types.begin(), types.end(), sym->type);
             msym.type_id = (it != types.end()) ? std::distance(types.begin(), it) : 0;
-            msym.stack_offset = sym.kind == SymbolKind::FUNCTION 
-                ? sym.entry_ip + sizeof(BytecodeHeader) 
-                : sym.stackOffset;
+            msym.stack_offset = sym->kind == SymbolKind::FUNCTION 
+                ? (sym->entry_ip < code_offsets.size() ? code_offsets[sym->entry_ip] + code_offset : 0)
+                : sym->stackOffset;
             msym.flags = 0;
 
             meta.symbols.push_back(msym);
-            verbose_cout << "  --> Add symbol: " << sym.name << std::endl;
+            verbose_cout << "  --> Add symbol: " << sym->name << std::endl;
         }
 
         return meta;
 #undef verbose_cout
     }
 
-    void writeBytecode(const std::string& filename, const std::vector<uint8_t>& code, const MetaData& meta, uint8_t word_size) {
+    std::vector<uint8_t> buildDataSection(const std::vector<uint64_t>& constants, const std::vector<uint8_t>& image, uint32_t image_base) {
+        std::vector<uint8_t> data;
+        if(image_base > image.size())
+            image_base = image.size();
+
+        if(constants.empty() && image.size() == image_base)
+            return data;
+
+        BytecodeDataHeader data_hdr {};
+        data_hdr.const_count = constants.size();
+        data_hdr.image_base = image_base;
+        data_hdr.image_size = image.size() - image_base;
+
+        write_bytes(data, &data_hdr, sizeof(data_hdr));
+        write_bytes(data, constants.data(), constants.size() * sizeof(uint64_t));
+        write_bytes(data, image.data() + image_base, data_hdr.image_size);
+
+        return data;
+    }
+
+    // uint32_t decompressed size followed by the LZ block, empty sections stay empty
+    static std::vector<uint8_t> packSection(const std::vector<uint8_t>& raw) {
+        std::vector<uint8_t> packed;
+        if(raw.empty())
+            return packed;
+
+        uint32_t raw_size = raw.size();
+        write_bytes(packed, &raw_size, sizeof(raw_size));
+
+        std::vector<uint8_t> block = lzCompress(raw.data(), raw.size());
+        packed.insert(packed.end(), block.begin(), block.end());
+
+        return packed;
+    }
+
+    void writeBytecode(const std::string& filename, const std::vector<uint8_t>& code_raw, const std::vector<uint8_t>& data_raw, const MetaData& meta, uint8_t word_size, uint32_t flags) {
+        bool compress = flags & BC_FLAG_COMPRESSED;
+        const std::vector<uint8_t>& code = compress ? packSection(code_raw) : code_raw;
+        const std::vector<uint8_t>& data = compress ? packSection(data_raw) : data_raw;
+
         uint32_t meta_size = sizeof(BytecodeMetaHeader) + meta.types.size() * sizeof(MetaType) + meta.symbols.size() * sizeof(MetaSymbol) + meta.string_pool.size();
-        BytecodeHeader hdr = buildBytecodeHeader(code.size(), meta_size, word_size);
+        BytecodeHeader hdr = buildBytecodeHeader(code.size(), data.size(), meta_size, word_size, flags);
 
-        std::ofstream fout(filename, std::ios::binary);
-        fout.write(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+        std::vector<uint8_t> file;
+        file.reserve(hdr.meta_offset + hdr.meta_size);
+        write_bytes(file, &hdr, sizeof(hdr));
+
+        // 1. Data (padded to its aligned offset)
+        file.resize(hdr.data_offset, 0);
+        write_bytes(file, data.data(), data.size());
 
-        // 1. Code
-        fout.write(reinterpret_cast<const char*>(code.data()), code.size());
+        // 2. Code
+        write_bytes(file, code.data(), code.size());
 
-        // 2. Meta
+        // 3. Meta
         BytecodeMetaHeader meta_hdr{};
         meta_hdr.symbol_count = meta.symbols.size();
         meta_hdr.type_count = meta.types.size();
         meta_hdr.string_pool_size = meta.string_pool.size();
-        fout.write(reinterpret_cast<char*>(&meta_hdr), sizeof(meta_hdr));
+        write_bytes(file, &meta_hdr, sizeof(meta_hdr));
 
-        // 2a. Types
-        fout.write(reinterpret_cast<const char*>(meta.types.data()), meta.types.size() * sizeof(MetaType));
+        // 3a. Types
+        write_bytes(file, meta.types.data(), meta.types.size() * sizeof(MetaType));
 
-        // 2b. Symbols
-        fout.write(reinterpret_cast<const char*>(meta.symbols.data()), meta.symbols.size() * sizeof(MetaSymbol));
+        // 3b. Symbols
+        write_bytes(file, meta.symbols.data(), meta.symbols.size() * sizeof(MetaSymbol));
 
-        // 2c. String pool
-        fout.write(meta.string_pool.data(), meta.string_pool.size());
+        // 3c. String pool
+        write_bytes(file, meta.string_pool.data(), meta.string_pool.size());
 
+        // 4. Checksum over everything written
+        hdr.checksum = bytecodeChecksum(file.data(), file.size());
+        std::memcpy(file.data() + offsetof(BytecodeHeader, checksum), &hdr.checksum, sizeof(hdr.checksum));
+
+        std::ofstream fout(filename, std::ios::binary);
+        fout.write(reinterpret_cast<const char*>(file.data()), file.size());
         fout.close();
     }
 };
@@ -1,12 +1,14 @@
 #include "bytecode.hpp"
 #include "compiler.hpp"
 #include "compiler/errno.h"
+#include "compiler/ir.hpp"
 #include <cstddef>
 #include <cstdint>
 #include <exception>
 #include <iostream>
 #include <ostream>
 #include <stdexcept>
+#include <utility>
 
 #include "types.hpp"
 #include "vmreg_defines.hpp"
@@ -17,40 +19,85 @@
 #endif
 
 namespace ULang {
+    // 8-byte (and untyped) values use plain LD/ST
+    Opcode loadOpcode(const DataType* type) {
+        bool sign = type && (type->flags & SIGN);
+
+        switch(type ? type->size : 0) {
+            case 1:  return sign ? Opcode::LD8S  : Opcode::LD8;
+            case 2:  return sign ? Opcode::LD16S : Opcode::LD16;
+            case 4:  return sign ? Opcode::LD32S : Opcode::LD32;
+            default: return Opcode::LD;
+        }
+    }
+
+    Opcode storeOpcode(const DataType* type) {
+        switch(type ? type->size : 0) {
+            case 1:  return Opcode::ST8;
+            case 2:  return Opcode::ST16;
+            case 4:  return Opcode::ST32;
+            default: return Opcode::ST;
+        }
+    }
+
+    // narrower types are loaded extended to 64 bits and wrap when stored,
+    // 32-bit ones get their own forms so that overflow wraps before DIV sees it,
+    // the signed ones sign-extend their result like LD32S does
+    Opcode binopOpcode(BinopType op, const DataType* type) {
+        bool sign = type && (type->flags & SIGN);
+        bool w32  = type && type->size == 4;
+
+        switch(op) {
+            case BinopType::ADDITION:
+                if(w32) return sign ? Opcode::IADD32 : Opcode::ADD32;
+                return Opcode::ADD;
+            case BinopType::SUBSTRACTION:
+                if(w32) return sign ? Opcode::ISUB32 : Opcode::SUB32;
+                return Opcode::SUB;
+            case BinopType::MULTIPLICATION:
+                if(w32) return sign ? Opcode::IMUL32 : Opcode::MUL32;
+                return Opcode::MUL;
+            case BinopType::DIVISION:
+                if(w32) return sign ? Opcode::IDIV32 : Opcode::DIV32;
+                return sign ? Opcode::IDIV : Opcode::DIV;
+        }
+
+        return Opcode::NOP;
+    }
+
     Operand CompilerInstance::compileNode(ASTNode* node, std::vector<Instruction>& out) {
         // TODO: locations in exceptions
 
         if(!node) {
-            std::cout << "warning: null node" << std::endl;
+            std::cerr << "warning: null node" << std::endl;
             return OP_GET_NULL;
         }
 
-        this->verbose_nl("Compile AST node '" + (node->name.empty() ? "unnamed" : node->name) + "'");
+        TRACE_NL("Compile AST node '" + (node->name().empty() ? std::string("unnamed") : node->name()) + "'");
         this->verbose_ascend();
 
         std::vector<bool> tmp_snapshot = this->tmp_used;
         Operand result = OP_GET_NULL;
-        Instruction instruction;
 
         try {
             switch(node->type) {
                 case ASTNodeType::NUMBER: {
                     this->verbose_descend();
-                    return {OperandType::OP_IMMEDIATE, node->val};
+                    return this->makeLiteral(node->val);
                 }
     
                 case ASTNodeType::VARIABLE: {
                     if(!node->symbol) {
                         throw CompilerSyntaxException(
                             CompilerSyntaxException::Severity::Error,
-                            "Undefined variable: " + node->name,
+                            "Undefined variable: " + node->name(),
                             ULANG_LOCATION_NULL,
                             ULANG_SYNT_ERR_VAR_UNDEFINED
                         );
                     }
     
                     Operand reg = this->allocTmpReg();
-                    this->emit(this->ctx, Opcode::LD, reg, {OperandType::OP_REFERENCE, node->symbol->stackOffset});
+                    this->emit(this->ctx, loadOpcode(node->symbol->type), reg, {OperandType::OP_REFERENCE, node->symbol->stackOffset});
 
                     this->verbose_descend();
                     return reg;
@@ -61,7 +108,7 @@ namespace ULang {
                     if(!node->lefthand || !node->lefthand->symbol)
                         throw std::runtime_error("Assignment target missing");
     
-                    this->emit(this->ctx, Opcode::ST, {OperandType::OP_REFERENCE, node->lefthand->symbol->stackOffset}, R);
+                    this->emit(this->ctx, storeOpcode(node->lefthand->symbol->type), {OperandType::OP_REFERENCE, node->lefthand->symbol->stackOffset}, R);
     
                     if(R.type == OperandType::OP_REGISTER && R.data >= R_TMP0.reg_no && R.data < R_TMP0.reg_no + this->tmp_used.size())
                         this->freeTmpReg(R, true);
@@ -71,12 +118,19 @@ namespace ULang {
                 }
     
                 case ASTNodeType::DECLARATION: {
-                    if(node->initial) {
+                    uint64_t val;
+
+                    // global code runs exactly once, constant initializers go straight to the data section
+                    if(!this->currentFunction && this->foldConstant(node->initial, val)) {
+                        this->emitStaticInit(node->symbol->stackOffset, node->symbol->type->size, val);
+                    } else if(node->initial) {
                         Operand R = this->compileNode(node->initial, out);
-                        this->emit(this->ctx, Opcode::ST, {OperandType::OP_REFERENCE, node->symbol->stackOffset}, R);
+                        this->emit(this->ctx, storeOpcode(node->symbol->type), {OperandType::OP_REFERENCE, node->symbol->stackOffset}, R);
     
                         if(R.type == OperandType::OP_REGISTER && R.data >= R_TMP0.reg_no && R.data < R_TMP0.reg_no + this->tmp_used.size())
                             this->freeTmpReg(R, true);
+                    } else if(this->cparams.OExplicitZero) {
+                        this->emitZeroFill(node->symbol->stackOffset, node->symbol->type->size);
                     }
     
                     this->verbose_descend();
@@ -84,43 +138,8 @@ namespace ULang {
                 }
     
                 case ASTNodeType::BINOP: {
-                    Operand L = this->compileNode(node->lefthand, out);
-                    Operand R = this->compileNode(node->righthand, out);
-    
-                    if(L.type != OperandType::OP_REGISTER && R.type != OperandType::OP_REGISTER) {
-                        L = this->allocTmpReg();
-                        this->emit(this->ctx, Opcode::MOV, L, OP_GET_NULL);
-                    }
-    
-                    switch(node->op) {
-                        case BinopType::ADDITION:       instruction.opcode = Opcode::ADD; break;
-                        case BinopType::SUBSTRACTION:   instruction.opcode = Opcode::SUB; break;
-                        case BinopType::MULTIPLICATION: instruction.opcode = Opcode::MUL; break;
-                        case BinopType::DIVISION:       instruction.opcode = Opcode::DIV; break;
-                    }
-    
-                    this->verbose_nl("BINOP: ");
-                    this->verbose_print("L: "); this->verbose_print(node->lefthand->val);
-                    this->verbose_print("R: "); this->verbose_print(node->righthand->val);
-    
-                    instruction.operands.push_back(L);
-                    instruction.operands.push_back(R);
-                    out.push_back(instruction);
-    
-                    // handle division by zero
-                    if( node->op == BinopType::DIVISION && 
-                        (R.type == OperandType::OP_IMMEDIATE || R.type == OperandType::OP_CONSTANT) &&
-                        R.data == 0) {
-                            this->friendlyException(CompilerSyntaxException(
-                                CompilerSyntaxException::Severity::Warning,
-                                "Division by zero", ULANG_LOCATION_NULL,
-                                ULANG_SYNT_WARN_DIVISION_ZERO
-                            ));
-                    }
-    
-                    if(R.type == OperandType::OP_REGISTER && R.data >= R_TMP0.reg_no && R.data < R_TMP0.reg_no + this->tmp_used.size())
-                        this->freeTmpReg(R, true);
-                    
+                    Operand L = this->compileBinop(node, out);
+
                     this->verbose_descend();
                     return L;
                 }
@@ -166,8 +185,9 @@ namespace ULang {
                             );
                         }
     
-                        const DataType* retExpr_type = getType(node->initial, node->initial->symbol ? node->initial->symbol->where : ULANG_LOCATION_NULL);
-                        if(retExpr_type != ret_type) {
+                        // literals adapt to the return type
+                        const DataType* retExpr_type = node->initial->value_type;
+                        if(retExpr_type && retExpr_type != ret_type) {
                             // TODO: implicit casts
     
                             throw CompilerSyntaxException(
@@ -187,7 +207,7 @@ namespace ULang {
                         if(ret_type != &TYPE_VOID) {
                             throw CompilerSyntaxException(
                                 CompilerSyntaxException::Severity::Error,
-                                "non-void function must return a value: '" + node->name + "'",
+                                "non-void function must return a value: '" + node->name() + "'",
                                 node->symbol->where,
                                 ULANG_SYNT_ERR_FN_NO_RET
                             );
@@ -204,27 +224,17 @@ namespace ULang {
                     // TODO: calling convention
     
                     if(!node->symbol)
-                        throw std::runtime_error("function symbol not set for FN_CALL: '" + node->name + "'");
+                        throw std::runtime_error("function symbol not set for FN_CALL: '" + node->name() + "'");
                     if(node->symbol->kind != SymbolKind::FUNCTION)
-                        throw std::runtime_error("invalid symbol in FN_CALL: '" + node->name + "'");
+                        throw std::runtime_error("invalid symbol in FN_CALL: '" + node->name() + "'");
     
                     for(ASTNode* arg: node->args)
                         this->compileNode(arg, out);
     
-                    this->emit(this->ctx, Opcode::CALL, {
-                        OperandType::OP_REFERENCE, 
-                        node->symbol->entry_ip
-                    }, OP_GET_NULL);
-    
-                    if(node->target_symbol) {
-                        this->emit(this->ctx, Opcode::MOV, {
-                            OperandType::OP_REFERENCE, 
-                            node->target_symbol->stackOffset}, 
-                        {
-                            OperandType::OP_REGISTER, 
-                            R_FNR.reg_no
-                        });
-                    }
+                    // functions are compiled after the global code, the target is patched in compile()
+                    // the caller stores FNR where needed (ASSIGNMENT/DECLARATION)
+                    this->ctx.call_fixups.push_back({static_cast<uint32_t>(this->ctx.instructions.size()), node->symbol});
+                    this->emit(this->ctx, Opcode::CALL, this->makeIMM(0), OP_GET_NULL);
 
                     this->verbose_descend();
                     return {
@@ -237,11 +247,11 @@ namespace ULang {
                     throw std::runtime_error("invalid AST node type");
             }
         } catch(std::exception& e) {
-            std::cerr << "compileNode() failed for '" << node->name << "' type=" << int(node->type) << std::endl;
+            std::cerr << "compileNode() failed for '" << node->name() << "' type=" << int(node->type) << std::endl;
             std::cerr << "  what=" << e.what() << std::endl;
             
             this->verbose_descend();
-            throw e;
+            throw;
         }
 
 
@@ -258,9 +268,142 @@ namespace ULang {
         return result;
     }
 
+    Operand CompilerInstance::compileBinop(ASTNode* node, std::vector<Instruction>& out) {
+        // post-order walk on explicit stacks, operands are compiled left to right as the recursion would
+        std::vector<std::pair<ASTNode*, bool>> stack = {{node, false}};
+        std::vector<Operand> values;
+
+        while(!stack.empty()) {
+            auto [n, children_done] = stack.back();
+            stack.pop_back();
+
+            if(n->type != ASTNodeType::BINOP) {
+                values.push_back(this->compileNode(n, out));
+                continue;
+            }
+
+            if(!children_done) {
+                stack.push_back({n, true});
+                stack.push_back({n->righthand, false});
+                stack.push_back({n->lefthand, false});
+                continue;
+            }
+
+            Operand R = values.back(); values.pop_back();
+            Operand L = values.back(); values.pop_back();
+
+            // the result goes to the left operand, literals have to be moved to a register first
+            if(L.type != OperandType::OP_REGISTER) {
+                Operand tmp = this->allocTmpReg();
+                this->emit(this->ctx, Opcode::MOV, tmp, L);
+                L = tmp;
+            }
+
+            // divisions leave the remainder in TMP0, keep a pending operand held there
+            Operand tmp0{OperandType::OP_REGISTER, R_TMP0.reg_no};
+            bool save_tmp0 = n->op == BinopType::DIVISION && this->tmp_used[0] &&
+                !(L.type == tmp0.type && L.data == tmp0.data) &&
+                !(R.type == tmp0.type && R.data == tmp0.data);
+
+            if(save_tmp0)
+                this->emit(this->ctx, Opcode::PUSH, tmp0, OP_GET_NULL);
+
+            Instruction instruction;
+            instruction.opcode = binopOpcode(n->op, n->value_type);
+            instruction.operands.push_back(L);
+            instruction.operands.push_back(R);
+            out.push_back(instruction);
+
+            if(save_tmp0)
+                this->emit(this->ctx, Opcode::POP, tmp0, OP_GET_NULL);
+
+            // handle division by zero
+            // a pooled constant operand holds its pool index
+            if( n->op == BinopType::DIVISION && (
+                (R.type == OperandType::OP_IMMEDIATE && R.data == 0) ||
+                (R.type == OperandType::OP_CONSTANT && this->ctx.constants[R.data] == 0))) {
+                    this->friendlyException(CompilerSyntaxException(
+                        CompilerSyntaxException::Severity::Warning,
+                        "Division by zero", ULANG_LOCATION_NULL,
+                        ULANG_SYNT_WARN_DIVISION_ZERO
+                    ));
+            }
+
+            if(R.type == OperandType::OP_REGISTER && R.data >= R_TMP0.reg_no && R.data < R_TMP0.reg_no + this->tmp_used.size())
+                this->freeTmpReg(R, true);
+
+            values.push_back(L);
+        }
+
+        return values.back();
+    }
+
+    void CompilerInstance::emitZeroFill(uint32_t offset, uint32_t size) {
+        std::vector<Instruction>& instrs = this->ctx.instructions;
+
+        // MOV CNT, size; MEMSET &offset, 0 just before -> grow it when adjacent
+        if(instrs.size() >= 2) {
+            Instruction& mov = instrs[instrs.size() - 2];
+            Instruction& set = instrs[instrs.size() - 1];
+
+            if( set.opcode == Opcode::MEMSET && 
+                mov.opcode == Opcode::MOV && 
+                mov.operands[0].type == OperandType::OP_REGISTER && mov.operands[0].data == R_CNT.reg_no &&
+                mov.operands[1].type == OperandType::OP_IMMEDIATE &&
+                set.operands[0].type == OperandType::OP_REFERENCE &&
+                set.operands[0].data + mov.operands[1].data == offset) {
+                    mov.operands[1].data += size;
+                    return;
+            }
+        }
+
+        this->emit(this->ctx, Opcode::MOV, {OperandType::OP_REGISTER, R_CNT.reg_no}, this->makeIMM(size));
+        this->emit(this->ctx, Opcode::MEMSET, this->makeRef(offset), this->makeIMM(0));
+    }
+
+    void CompilerInstance::emitStaticInit(uint32_t offset, uint32_t size, uint64_t val) {
+        std::vector<uint8_t>& image = this->ctx.image;
+        if(image.size() < offset + size)
+            image.resize(offset + size, 0);
+
+        for(uint32_t b = 0; b < size; b++)
+            image[offset + b] = uint8_t((val >> (8 * b)) & 0xFF);
+
+        if(offset < this->ctx.image_base)
+            this->ctx.image_base = offset;
+
+        TRACE_NL("Static init &");
+        TRACE_PRINT(offset);
+    }
+
+    // LEB128, 7 bits per byte, least significant first
+    static void writeVarint(std::vector<uint8_t>& out, uint32_t val) {
+        while(val >= 0x80) {
+            out.push_back(uint8_t(val | 0x80));
+            val >>= 7;
+        }
+
+        out.push_back(uint8_t(val));
+    }
+
     void CompilerInstance::serializeInstruction(const Instruction& instr, std::vector<uint8_t>& out) {
         out.push_back(static_cast<uint8_t>(instr.opcode));
 
+        if(this->cparams.compact) {
+            uint8_t types = 0;
+            for(size_t i = 0; i < instr.operands.size() && i < ULANG_OP_COUNT; i++)
+                types |= (static_cast<uint8_t>(instr.operands[i].type) & 0x0F) << (4 * i);
+
+            out.push_back(types);
+
+            for(size_t i = 0; i < instr.operands.size() && i < ULANG_OP_COUNT; i++) {
+                if(instr.operands[i].type != OperandType::OP_NULL)
+                    writeVarint(out, instr.operands[i].data);
+            }
+
+            return;
+        }
+
         for(size_t i = 0; i < 2; i++) {
             Operand op{};
 
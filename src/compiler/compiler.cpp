@@ -1,12 +1,15 @@
 #include "compiler.hpp"
 #include "bytecode.hpp"
+#include "compiler/ir.hpp"
 #include "compiler/params.hpp"
 #include "types.hpp"
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <exception>
 #include <iostream>
+#include <memory>
 #include <ostream>
 #include <stdexcept>
 #include <string>
@@ -15,7 +18,7 @@
 #include "errno.h"
 
 #define cout_verbose                                                           \
-if (this->cparams.verbose)                                                   \
+if (ULANG_TRACE_ENABLED && this->cparams.verbose)                            \
 std::cout
 
 namespace ULang {
@@ -26,108 +29,47 @@ namespace ULang {
             out.push_back(static_cast<uint8_t>((op.data >> (8 * i)) & 0xFF));
     }
 
-    CompilerInstance::CompilerInstance(const std::string& source, CompilerParameters& cparams)
-    : lexer(source), cparams(cparams) {
+    CompilerInstance::CompilerInstance(std::string_view source, CompilerParameters& cparams)
+    : lexer(source), tokens(lexer), cparams(cparams) {
         this->symbols.getGlobalScope()->ci_ptr = this;
     }
 
     void CompilerInstance::friendlyException(CompilerSyntaxException e) {
         this->exceptions_friendly.push_back(e);
-        std::cout << e.fmt(true) << std::endl;
+        std::cerr << e.fmt(true) << std::endl;
     }
 
-    const DataType* CompilerInstance::getType(ASTNode* node, SourceLocation loc) {
-        if(!node)
-            return nullptr;
-
-        switch(node->type) {
-            case ASTNodeType::DECLARATION: 
-                return node->symbol ? node->symbol->type : nullptr;
-
-            case ASTNodeType::ASSIGNMENT:
-                return node->righthand ? getType(node->righthand, loc) : nullptr;
-
-            case ASTNodeType::NUMBER:
-                return &TYPE_INT32;
-
-            case ASTNodeType::FN_ARG:
-            case ASTNodeType::VARIABLE:
-                if(node->symbol) 
-                    return node->symbol->type;
-
-                throw CompilerSyntaxException(
-                    CompilerSyntaxException::Severity::Error,
-                    "Could not determine type for '" + node->name + "'",
-                    loc,
-                    ULANG_SYNT_ERR_TYPE_DETERMINE_FAIL
-                );
-
-            case ASTNodeType::BINOP: {
-                SourceLocation loc_left  = node->lefthand && node->lefthand->symbol ? node->lefthand->symbol->where : loc;
-                SourceLocation loc_right = node->righthand && node->righthand->symbol ? node->righthand->symbol->where : loc;
-
-                const DataType* left  = getType(node->lefthand, loc_left);
-                const DataType* right = getType(node->righthand, loc_right);
-
-                if((left->flags & SIGN) != (right->flags & SIGN)) {
-                    this->friendlyException(CompilerSyntaxException(
-                        CompilerSyntaxException::Severity::Warning,
-                        "Operand types '" + left->name + "' and '" + right->name + "' differ in signedness",
-                        loc,
-                        ULANG_SYNT_WARN_TYPES_SIGN_DIFF
-                    ));
-                }
-
-                if(left->size != right->size) {
-                    this->friendlyException(CompilerSyntaxException(
-                        CompilerSyntaxException::Severity::Warning,
-                        "Operand types '" + left->name + "' and '" + right->name + "' differ in sizes",
-                        loc,
-                        ULANG_SYNT_WARN_TYPES_SIZE_DIFF
-                    ));
-                }
-
-                return left;
-            }
-        }
-
-        return nullptr;
-    }
-
-    const Token& CompilerInstance::expectToken(TokenType type) {
-        if(this->tokens[this->pos].type != type) {
+    Token CompilerInstance::expectToken(TokenType type) {
+        const Token& tok = this->tokens.peek();
+        if(tok.type != type) {
             throw CompilerSyntaxException(
                 CompilerSyntaxException::Severity::Error, 
-                "Unexcepted token: '" + this->tokens[this->pos].text + "', excepted " + toktype2str(type),
-                this->tokens[this->pos].loc,
+                "Unexcepted token: '" + std::string(tok.text) + "', excepted " + toktype2str(type),
+                tok.loc,
                 ULANG_SYNT_ERR_UNEXCEPT_TOK
             );
         }
 
-        return this->tokens[this->pos++];
+        return this->tokens.next();
     }
 
-    const Token& CompilerInstance::expectToken(const std::string& token) {
-        if(this->pos >= this->tokens.size() && this->tokens[this->pos].text != token) {
+    Token CompilerInstance::expectToken(const std::string& token) {
+        const Token& tok = this->tokens.peek();
+        if(tok.text != token) {
             throw CompilerSyntaxException(
                 CompilerSyntaxException::Severity::Error,
-                "Unexcepted token: '" + this->tokens[this->pos].text + "', excepted '" + token + "'",
-                this->tokens[this->pos].loc,
+                "Unexcepted token: '" + std::string(tok.text) + "', excepted '" + token + "'",
+                tok.loc,
                 ULANG_SYNT_ERR_UNEXCEPT_TOK
             );
         }
 
-        return this->tokens[this->pos++];
+        return this->tokens.next();
     }
 
     bool CompilerInstance::matchToken(TokenType type) {
-        std::cout << "matchToken? current=" << toktype2str(this->tokens[this->pos].type) << " expected=" << toktype2str(type) << std::endl;
-        
-        //if(this->pos >= this->tokens.size()) 
-        // return false;
-
-        if(this->pos >= this->tokens.size() && this->tokens[this->pos].type == type) {
-            this->pos++;
+        if(this->tokens.peek().type == type) {
+            this->tokens.advance();
             return true;
         }
 
@@ -135,10 +77,8 @@ namespace ULang {
     }
 
     bool CompilerInstance::matchToken(const std::string &token) {
-        std::cout << "matchToken? current=" << toktype2str(this->tokens[this->pos].type) << " expected=" << token << std::endl;
-
-        if(this->tokens[this->pos].text == token) {
-            this->pos++;
+        if(this->tokens.peek().text == token) {
+            this->tokens.advance();
             return true;
         }
         
@@ -147,33 +87,68 @@ namespace ULang {
 
     //bool isBinop(TokenType tt);
 
-    std::vector<uint8_t> CompilerInstance::serializeProgram(const std::vector<Instruction>& program) {
+    std::vector<uint8_t> CompilerInstance::serializeProgram(const std::vector<Instruction>& program, std::vector<uint32_t>& offsets) {
         std::vector<uint8_t> bytecode;
         bytecode.reserve(256);
 
-        for(const Instruction& instr : program) {
-            this->serializeInstruction(instr, bytecode);
+        // fixed-size instructions are laid out right away, compact ones start at their shortest
+        offsets.assign(program.size() + 1, 0);
+        if(!this->cparams.compact) {
+            for(size_t i = 0; i < offsets.size(); i++)
+                offsets[i] = i * Instruction{}.calcTotalSz();
+        }
+
+        // compact branch targets are varints of the offsets they point to, so the layout is grown
+        // until it settles (offsets only ever grow, so does the encoding)
+        for(;;) {
+            std::vector<uint32_t> layout;
+            layout.reserve(offsets.size());
+            bytecode.clear();
+
+            for(const Instruction& instr : program) {
+                layout.push_back(bytecode.size());
+
+                int target = branchTargetOperand(instr.opcode);
+                if(target < 0) {
+                    this->serializeInstruction(instr, bytecode);
+                    continue;
+                }
+
+                // branch targets are instruction indices until now, the loader expects code offsets
+                Instruction branch = instr;
+                branch.operands[target].data = offsets.at(branch.operands[target].data);
+                this->serializeInstruction(branch, bytecode);
+            }
+
+            layout.push_back(bytecode.size());
+            if(layout == offsets)
+                break;
+
+            offsets = layout;
         }
 
         return bytecode;
     }
 
     void CompilerInstance::buildAST() {
-        this->verbose_nl("Build AST tree");
+        TRACE_NL("Build AST tree");
         this->verbose_ascend();
 
-        this->ast_owned.clear();
-        this->pos = 0;
+        this->ast.clear();
+        this->ast_root = {};
+        this->tokens.start(internSourceFile(this->cparams.sourceFile));
 
-        while(this->tokens[this->pos].type != TokenType::EndOfFile) {
+        while(this->tokens.peek().type != TokenType::EndOfFile) {
             ASTNode* node_raw = nullptr;
 
-            switch(this->tokens[this->pos].type) {
+            switch(this->tokens.peek().type) {
                 case TokenType::TypeKeyword:
                     node_raw = this->parseVarDecl();
                     break;
                 case TokenType::Function:
                     node_raw = this->parseFnDecl();
+                    if(!node_raw)
+                        continue;
                     break;
 
                 default: {
@@ -186,7 +161,25 @@ namespace ULang {
             if(!node_raw)
                 throw std::runtime_error("Parser returned null AST node");
 
-            this->ast_owned.push_back(ASTPtr(node_raw));
+            this->ast_root.push(node_raw);
+        }
+
+        // in declaration order
+        std::vector<const Symbol*> undefined;
+        for(const auto& [sym, params]: this->fn_prototypes) {
+            if(!sym->defined)
+                undefined.push_back(sym);
+        }
+
+        std::sort(undefined.begin(), undefined.end(), [](const Symbol* a, const Symbol* b) {return a->symbolId < b->symbolId;});
+
+        for(const Symbol* sym: undefined) {
+            this->friendlyException(CompilerSyntaxException(
+                CompilerSyntaxException::Severity::Warning,
+                "Function '" + sym->name + "' declaration doesn't define it's body",
+                sym->where,
+                ULANG_SYNT_WARN_FN_NO_BODY
+            ));
         }
 
         this->verbose_descend();
@@ -203,16 +196,16 @@ namespace ULang {
     }
 
     void CompilerInstance::compile() {
-        std::cout << "Compile: " << this->cparams.sourceFile << std::endl;
+        cout_verbose << "Compile: " << this->cparams.sourceFile << std::endl;
 
         try {
-            this->tokens = this->lexer.tokenize();
             this->buildAST();
+            this->checkTypes();
         } catch (const CompilerSyntaxException &e) {
             std::cerr << e.fmt(true) << std::endl;
 
             if(e.getSeverity() == CompilerSyntaxException::Severity::Error) {
-                std::cout << "Compilation terminated" << std::endl;
+                std::cerr << "Compilation terminated" << std::endl;
                 exit(1);
             }
         } catch(const std::exception& e) {
@@ -220,60 +213,62 @@ namespace ULang {
             exit(1);
         }
 
-        this->verbose_nl("tokens: " + std::to_string(this->tokens.size()) + ", nodes: " + std::to_string(this->ast_owned.size()));
+        TRACE_NL("tokens: " + std::to_string(this->tokens.count()) + ", nodes: " + std::to_string(this->ast.nodeCount()));
 
         // GenerationContext ctx;
         this->ctx.symtab = &this->symbols;
         this->ctx.stack_top = 0x00;
 
-        // placeholder jump to main
-        uint32_t jmp_pos = this->ctx.instructions.size();
-        this->emit(this->ctx, Opcode::JMP, {OperandType::OP_NULL}, {OperandType::OP_NULL}); // patch below
+        // -O compiles every function through the IR, falling back to compileNode() where it can't be lowered
+        IRPassManager passes;
+        passes.add(std::make_unique<IRValueNumbering>());
+        passes.add(std::make_unique<IRDeadCode>());
 
-        // functions first
-        for(const auto& node: this->ast_owned) {
-            if(node->type != ASTNodeType::FN_DEF)
+        bool global_done = this->cparams.optimize && this->compileIR(nullptr, passes);
+
+        // global code first, execution starts at the first instruction
+        for(ASTNode* nodeg: this->ast_root) {
+            if(global_done || nodeg->type == ASTNodeType::FN_DEF)
                 continue;
 
-            ASTNode* nodeg = node.get();
-            
-            this->verbose_nl("AST function node type: ");
-            this->verbose_print(static_cast<int>(node->type));
+            TRACE_NL("AST normal node type: ");
+            TRACE_PRINT(static_cast<int>(nodeg->type));
             this->verbose_ascend();
 
-            this->verbose_nl("node.get() = "); this->verbose_print((uintptr_t) &nodeg);
-            this->verbose_nl("node.get()->symbol = "); this->verbose_print((uintptr_t) &nodeg->symbol);
+            TRACE_NL("node.get() = "); TRACE_PRINT((uintptr_t) &nodeg);
+            TRACE_NL("node.get()->symbol = "); TRACE_PRINT((uintptr_t) &nodeg->symbol);
 
             this->compileNode(nodeg, ctx.instructions);
             this->verbose_descend();
         }
 
-        // patch JMP operand
-        this->ctx.instructions[jmp_pos].operands[0] = {
-            OperandType::OP_IMMEDIATE, 
-            static_cast<uint32_t>(this->ctx.instructions.size())
-        };
+        if(!global_done)
+            this->emit(this->ctx, Opcode::HALT, {OperandType::OP_NULL}, {OperandType::OP_NULL});
+
+        // functions then
+        for(ASTNode* nodeg: this->ast_root) {
+            if(nodeg->type != ASTNodeType::FN_DEF)
+                continue;
 
-        // global code then
-        for(const auto& node: this->ast_owned) {
-            ASTNode* nodeg = node.get();
-            if(nodeg->type == ASTNodeType::FN_DEF)
+            if(this->cparams.optimize && this->compileIR(nodeg, passes))
                 continue;
 
-            this->verbose_nl("AST normal node type: ");
-            this->verbose_print(static_cast<int>(node->type));
+            TRACE_NL("AST function node type: ");
+            TRACE_PRINT(static_cast<int>(nodeg->type));
             this->verbose_ascend();
 
-            this->verbose_nl("node.get() = "); this->verbose_print((uintptr_t) &nodeg);
-            this->verbose_nl("node.get()->symbol = "); this->verbose_print((uintptr_t) &nodeg->symbol);
+            TRACE_NL("node.get() = "); TRACE_PRINT((uintptr_t) &nodeg);
+            TRACE_NL("node.get()->symbol = "); TRACE_PRINT((uintptr_t) &nodeg->symbol);
 
             this->compileNode(nodeg, ctx.instructions);
             this->verbose_descend();
         }
 
-        this->emit(this->ctx, Opcode::HALT, {OperandType::OP_NULL}, {OperandType::OP_NULL});
+        // every function has its entry now
+        for(const auto& [at, callee]: this->ctx.call_fixups)
+            this->ctx.instructions[at].operands[0].data = callee->entry_ip;
 
-        this->verbose_nl("\n");
+        TRACE_NL("\n");
 
         std::vector<const DataType*> types_vect = {
             &TYPE_INT8, &TYPE_INT16, &TYPE_INT32, &TYPE_INT64,
@@ -281,9 +276,24 @@ namespace ULang {
             &TYPE_CHAR
         };
 
-        MetaData meta = buildMeta(this->symbols, types_vect, this->cparams.verbose);
-        std::vector<uint8_t> code = this->serializeProgram(ctx.instructions);
-        writeBytecode(this->cparams.outFile, code, meta, 4);
+        std::vector<uint32_t> code_offsets;
+        std::vector<uint8_t> code = this->serializeProgram(ctx.instructions, code_offsets);
+        std::vector<uint8_t> data = buildDataSection(ctx.constants, ctx.image, ctx.image_base);
+
+        // function symbols point into the uncompressed layout
+        BytecodeHeader layout {};
+        layout.code_size = code.size();
+        layout.data_size = data.size();
+        layoutSections(layout);
+
+        MetaData meta = buildMeta(this->symbols, types_vect, code_offsets, layout.code_offset, this->cparams.verbose);
+
+        uint32_t flags = 0;
+        if(this->cparams.compact)   flags |= BC_FLAG_COMPACT;
+        if(this->cparams.compress)  flags |= BC_FLAG_COMPRESSED;
+        if(this->cparams.optimize)  flags |= BC_FLAG_OPTIMIZED;
+
+        writeBytecode(this->cparams.outFile, code, data, meta, 4, flags);
     }
 };
 
@@ -4,14 +4,21 @@
 #include "bytecode.hpp"
 #include "essentials.hpp"
 #include "compiler/params.hpp"
+#include "compiler/scan.hpp"
+#include "compiler/source.hpp"
 #include "types.hpp"
 
 #include <cstdint>
+#include <deque>
 #include <exception>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 #ifndef THROW_AWAY
 #define THROW_AWAY (void)
@@ -22,15 +29,41 @@
     try {CODE} catch(std::exception& e) {THROW_AWAY e;}
 #endif
 
+// ULANG_NO_TRACE (make RELEASE=1) compiles the verbose trace out
+#ifdef ULANG_NO_TRACE
+#define ULANG_TRACE_ENABLED false
+#else
+#define ULANG_TRACE_ENABLED true
+#endif
+
+// verbose trace of a compiler instance, the arguments are only evaluated with --verbose
+#define TRACE_NL(...)       \
+    do {if(ULANG_TRACE_ENABLED && this->cparams.verbose) this->verbose_nl(__VA_ARGS__);} while(0)
+
+#define TRACE_PRINT(...)    \
+    do {if(ULANG_TRACE_ENABLED && this->cparams.verbose) this->verbose_print(__VA_ARGS__);} while(0)
+
 namespace ULang {
     struct Symbol;
     class SymbolTable;
     class CompilerInstance;
+    struct IRInstr;
+    struct IRBlock;
+    class IRFunction;
+    class IRPassManager;
 
     struct GenerationContext {
         std::vector<Instruction> instructions;
         SymbolTable* symtab;
         uint32_t stack_top;
+
+        std::vector<uint64_t> constants;                    ///< constant pool
+        std::unordered_map<uint64_t, uint32_t> const_index; ///< value -> pool index
+
+        std::vector<std::pair<uint32_t, Symbol*>> call_fixups;  ///< CALL instruction index -> callee, patched once all functions are compiled
+
+        std::vector<uint8_t> image;                         ///< static data image indexed by heap offset
+        uint32_t image_base = UINT32_MAX;                   ///< lowest initialized offset in image
     };
 
     static inline void write_bytes(std::vector<uint8_t>& out, const void* src, size_t size) {
@@ -39,7 +72,7 @@ namespace ULang {
     }
     
 #ifndef ULANG_LOCATION_NULL
-    #define ULANG_LOCATION_NULL (ULang::SourceLocation) {nullptr, "(unknown)", 0, 0}
+    #define ULANG_LOCATION_NULL (ULang::SourceLocation) {nullptr, ULANG_FILE_UNKNOWN, 0, 0}
 #endif
 
     inline std::vector<std::string> builtin_ids = {
@@ -71,33 +104,110 @@ namespace ULang {
         DIVISION        ///< division
     };
 
+    struct ASTNode;
+
+    /**
+     * @brief Singly linked list of AST nodes, chained through ASTNode::next
+     */
+    struct ASTList {
+        ASTNode* first = nullptr;
+        ASTNode* last = nullptr;
+
+        struct iterator {
+            ASTNode* node;
+
+            ASTNode* operator*() const {return this->node;};
+            iterator& operator++();
+            bool operator!=(const iterator& other) const {return this->node != other.node;};
+        };
+
+        /**
+         * @brief Appends a node, a node can only be in one list
+         */
+        void push(ASTNode* node);
+
+        bool empty() const {return this->first == nullptr;};
+        ASTNode* back() const {return this->last;};
+
+        iterator begin() const {return {this->first};};
+        iterator end() const {return {nullptr};};
+    };
+
     /**
      * @brief AST nodes
+     *
+     * Nodes live in the ASTArena of the compilation and are never destroyed one by one, so they
+     * must stay trivially destructible. Fields that no node type uses together share storage.
      */
     struct ASTNode {
         ASTNodeType type;               ///< node type
-        uint32_t val;                    ///< value (if ASTNodeType::NUMBER)
-
-        std::string name;               ///< name
-
         BinopType op;                   ///< operator (if ASTNodeType::BINOP)
-        ASTNode* lefthand = nullptr;    ///< lefthand operand
-        ASTNode* righthand = nullptr;   ///< righthand operand
-        ASTNode* initial = nullptr;     ///< initial value (if ASTNodeType::DECLARATION)
 
         Symbol* symbol = nullptr;       ///< symbol
-        Symbol* target_symbol = nullptr;///< target symbol (where to store return value)
+        ASTNode* next = nullptr;        ///< next node in the parent's list
+
+        union {
+            uint64_t val = 0;           ///< value (if ASTNodeType::NUMBER)
+            ASTNode* lefthand;          ///< lefthand operand (BINOP, ASSIGNMENT), callee (FN_CALL)
+        };
+
+        union {
+            ASTNode* righthand = nullptr;   ///< righthand operand (BINOP, ASSIGNMENT)
+            ASTNode* initial;               ///< initial value (DECLARATION), return value (FN_RET)
+            Symbol* target_symbol;          ///< where to store the return value (FN_CALL)
+        };
 
-        std::vector<ASTNode*> body;     ///< function body (if ASTNodeType::FN_DEF)
-        std::vector<ASTNode*> args;     ///< function args (if ASTNodeType::FN_CALL)
-        const DataType* ret_type = nullptr;
+        const DataType* value_type = nullptr;   ///< type annotated by the type check
 
-        ASTNode(int64_t val);
-        ASTNode(const std::string& varname);
+        ASTList args;                   ///< parameters (FN_DEF), arguments (FN_CALL)
+        ASTList body;                   ///< function body (if ASTNodeType::FN_DEF)
+
+        ASTNode(uint64_t val);
         ASTNode(ASTNodeType t);
+
+        /**
+         * @brief Name of the symbol the node refers to, empty if it has none
+         */
+        const std::string& name() const;
     };
 
-    using ASTPtr = std::unique_ptr<ASTNode>;
+    static_assert(std::is_trivially_destructible_v<ASTNode>, "AST nodes are released with their arena");
+
+#define ULANG_AST_CHUNK_NODES 1024      ///< nodes per arena chunk
+
+    /**
+     * @brief Bump allocator owning every AST node of a compilation
+     */
+    class ASTArena {
+        private:
+        using Slot = std::aligned_storage_t<sizeof(ASTNode), alignof(ASTNode)>;
+
+        std::vector<std::unique_ptr<Slot[]>> chunks;
+        size_t used = ULANG_AST_CHUNK_NODES;    ///< slots taken in the last chunk
+
+        public:
+        template<typename... Args>
+        ASTNode* make(Args&&... args) {
+            if(this->used == ULANG_AST_CHUNK_NODES) {
+                this->chunks.emplace_back(new Slot[ULANG_AST_CHUNK_NODES]);
+                this->used = 0;
+            }
+
+            return new(&this->chunks.back()[this->used++]) ASTNode(std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief Releases all the nodes at once, chunk by chunk without visiting the nodes
+         */
+        void clear() {
+            this->chunks.clear();
+            this->used = ULANG_AST_CHUNK_NODES;
+        }
+
+        size_t nodeCount() const {
+            return this->chunks.empty() ? 0 : (this->chunks.size() - 1) * ULANG_AST_CHUNK_NODES + this->used;
+        }
+    };
 
     // ==================================================================
     // ======== TOKENS AND LEXER
@@ -147,7 +257,7 @@ namespace ULang {
 
     struct Token {
         TokenType type;
-        std::string text;
+        std::string_view text;  ///< slice of the source buffer
         SourceLocation loc;
     };
 
@@ -158,25 +268,97 @@ namespace ULang {
      */
     class Lexer {
         private:
-        std::string src;    ///< source code
+        std::string_view src;   ///< source code, owned by the caller
 
         size_t pos = 0;     ///< current position
         size_t line = 1;    ///< line number
         size_t col = 1;     ///< column number
+        uint32_t file = ULANG_FILE_UNKNOWN;     ///< file id of the locations
+
+        const ScanKernels* scan;    ///< character-class scanners
 
         char peek() const;
         char get();
 
+        /**
+         * @brief Advances over a run of bytes that contains no newline
+         */
+        void skipRun(size_t len);
+
         public:
 
+        /**
+         * @brief Rewinds to the start of the source
+         * @param file file id for the token locations
+         */
+        void reset(uint32_t file = ULANG_FILE_UNKNOWN);
+
+        /**
+         * @brief Scans the next token, EndOfFile once the source is exhausted
+         * @exception std::runtime_error
+         * @return Token token
+         */
+        Token next();
+
         /**
          * @brief converts source code to tokens
          * @exception std::runtime_error
          * @return std::vector<Token> token vector
          */
-        std::vector<Token> tokenize(const std::string& filename = "(unknown)");
+        std::vector<Token> tokenize(uint32_t file = ULANG_FILE_UNKNOWN);
 
-        Lexer(const std::string& input);
+        Lexer(std::string_view input);
+
+        /**
+         * @brief Selects the scanners, scanKernels() by default
+         */
+        void setScanKernels(const ScanKernels& kernels) {this->scan = &kernels;};
+    };
+
+#define ULANG_TOKEN_LOOKAHEAD 4     ///< tokens the parser can peek at
+
+    /**
+     * @brief Tokens pulled from the lexer on demand, only a small lookahead window is kept in memory
+     */
+    class TokenStream {
+        private:
+        Lexer& lexer;
+
+        Token window[ULANG_TOKEN_LOOKAHEAD];    ///< ring buffer of scanned, not yet consumed tokens
+        size_t head = 0;                        ///< window index of the current token
+        size_t filled = 0;                      ///< tokens in the window
+        size_t consumed = 0;                    ///< tokens consumed so far
+
+        public:
+        TokenStream(Lexer& lexer): lexer(lexer) {};
+
+        /**
+         * @brief Rewinds the lexer and drops the window
+         * @param file file id for the token locations
+         */
+        void start(uint32_t file);
+
+        /**
+         * @brief Returns a token without consuming it
+         * @exception std::runtime_error
+         * @param ahead 0 for the current token, less than ULANG_TOKEN_LOOKAHEAD
+         * @return const Token& token, valid until the stream is advanced
+         */
+        const Token& peek(size_t ahead = 0);
+
+        /**
+         * @brief Consumes and returns the current token
+         * @exception std::runtime_error
+         */
+        Token next();
+
+        /**
+         * @brief Consumes tokens
+         * @exception std::runtime_error
+         */
+        void advance(size_t n = 1);
+
+        size_t count() const {return this->consumed;};
     };
 
     // std::vector<ASTNode*> buildAST(const std::vector<Token>& tokens);
@@ -194,8 +376,42 @@ namespace ULang {
         FUNCTION
     };
 
+#define ULANG_ATOM_NONE         UINT32_MAX  ///< name that was never interned
+#define ULANG_SYMBOL_ID_BASE    16          ///< first symbol id, lower ids are reserved
+
+    /**
+     * @brief Interned identifier names, every distinct name gets a small integer atom
+     */
+    class NameTable {
+        private:
+        struct Slot {
+            uint32_t hash;
+            uint32_t atom;      ///< ULANG_ATOM_NONE if empty
+        };
+
+        std::deque<std::string> names;  ///< atom -> name, never moves
+        std::vector<Slot> slots;        ///< open addressing, power of two
+
+        void grow();
+
+        public:
+        /**
+         * @brief Returns the atom of a name, interning it first if needed
+         */
+        uint32_t intern(std::string_view name);
+
+        /**
+         * @brief Returns the atom of a name, ULANG_ATOM_NONE if it was never interned
+         */
+        uint32_t find(std::string_view name) const;
+
+        const std::string& name(uint32_t atom) const {return this->names[atom];};
+    };
+
     struct Symbol {
-        std::string name;
+        const std::string& name;    ///< interned, owned by the symbol table
+        uint32_t atom;
+        uint32_t scope;             ///< index of the declaring scope
         unsigned int symbolId;
 
         SymbolKind kind = SymbolKind::VARIABLE;
@@ -203,16 +419,21 @@ namespace ULang {
 
         uint32_t stackOffset;
         uint32_t entry_ip; ///< functions only
+        bool defined = false;       ///< functions only, the body has been parsed
 
         SourceLocation where;
+
+        Symbol(const std::string& name, uint32_t atom): name(name), atom(atom) {};
     };
 
     struct Scope {
         CompilerInstance* ci_ptr;
+        SymbolTable* table;         ///< owning table
+        uint32_t index;             ///< index in the owning table
 
         std::string _name;
 
-        std::unordered_map<std::string, Symbol> symbols;
+        std::vector<Symbol*> symbols;   ///< symbols declared here, in declaration order
         Scope* parent = nullptr;
         size_t nextOffset;
 
@@ -252,26 +473,61 @@ namespace ULang {
                         size_t align_head = 0,
                         size_t align_tail = 0);
         
-        const Symbol* lookup(const std::string& name) const;
-        const Symbol* lookup(unsigned int symbolId) const;
+        /**
+         * @brief Looks a name up in this scope and its parents
+         */
+        const Symbol* lookup(std::string_view name) const;
 
-        ~Scope();
+        /**
+         * @brief Returns the symbol if it is visible from this scope
+         */
+        const Symbol* lookup(unsigned int symbolId) const;
     };
 
+    /**
+     * @brief Scoped symbol table
+     *
+     * Symbols live in one dense list indexed by id and are found by name through a single
+     * open-addressing table keyed by (scope, atom). Scopes and symbols are kept until the table
+     * is destroyed, so pointers held by the AST stay valid after their scope is left.
+     */
     class SymbolTable {
         private:
+        struct Binding {
+            uint32_t scope;
+            uint32_t atom;
+            uint32_t symbol;    ///< index in symbol_list, UINT32_MAX if empty
+        };
+
+        NameTable names;
+        std::deque<Symbol> symbol_list;                 ///< id - ULANG_SYMBOL_ID_BASE -> symbol, never moves
+        std::vector<std::unique_ptr<Scope>> scopes;     ///< index -> scope
+        std::vector<Binding> bindings;                  ///< open addressing, power of two
+        size_t binding_count = 0;
+
         Scope* scope_global;
         Scope* scope_current;
 
-        unsigned int nextSymbolId;
+        static size_t bindingHash(uint32_t scope, uint32_t atom);
+        void growBindings();
+
+        /**
+         * @brief Finds the symbol bound to atom in exactly one scope
+         */
+        Symbol* find(uint32_t scope, uint32_t atom) const;
 
         public:
         SymbolTable();
-        ~SymbolTable();
 
         Scope* enter(const std::string& name);
         Scope* leave();
 
+        /**
+         * @brief Creates a symbol bound to name in scope
+         * @exception std::runtime_error if scope already has a symbol of that name
+         * @return Symbol* symbol, the caller fills in the rest
+         */
+        Symbol* bind(Scope* scope, const std::string& name, const char* what);
 
         /**
          * @brief Declares a symbol in current scope
@@ -309,9 +565,19 @@ namespace ULang {
                         size_t align_head = 0,
                         size_t align_tail = 0);
         
-        const Symbol* lookup(const std::string& name) const;
+        /**
+         * @brief Looks a name up in scope and its parents
+         */
+        const Symbol* lookupFrom(const Scope* scope, std::string_view name) const;
+
+        const Symbol* lookup(std::string_view name) const;
+
+        /**
+         * @brief Returns any symbol ever declared by id, including the ones of scopes already left
+         */
         const Symbol* lookup(unsigned int symbolId) const;
-        
+
+
         Scope* getCurrentScope() const;
         Scope* getGlobalScope() const;
     };
@@ -360,9 +626,31 @@ namespace ULang {
     // ======== COMPILATION, BYTECODE AND CONTEXT
     // ==================================================================
 
-    BytecodeHeader buildBytecodeHeader(uint32_t code_size, uint32_t meta_size, uint8_t word_size);
-    MetaData buildMeta(SymbolTable& symtable, const std::vector<const DataType*>& types0, bool verbose_en);
-    void writeBytecode(const std::string& filename, const std::vector<uint8_t>& code, const MetaData& meta, uint8_t word_size);
+    BytecodeHeader buildBytecodeHeader(uint32_t code_size, uint32_t data_size, uint32_t meta_size, uint8_t word_size, uint32_t flags);
+
+    /**
+     * @brief Builds the meta section
+     * 
+     * @param symtable symbol table
+     * @param types types to describe
+     * @param code_offsets code section offset of every instruction, function symbols point there
+     * @param code_offset file offset of the code section
+     * @param verbose_en verbose log
+     * @return MetaData 
+     */
+    MetaData buildMeta(SymbolTable& symtable, const std::vector<const DataType*>& types0, const std::vector<uint32_t>& code_offsets, uint32_t code_offset, bool verbose_en);
+
+    /**
+     * @brief Serializes the data section (BytecodeDataHeader, the constant pool and the static data image)
+     * 
+     * @param constants constant pool
+     * @param image static data image indexed by heap offset
+     * @param image_base first initialized offset in image
+     * @return std::vector<uint8_t> data section, empty if there is nothing to store
+     */
+    std::vector<uint8_t> buildDataSection(const std::vector<uint64_t>& constants, const std::vector<uint8_t>& image, uint32_t image_base);
+
+    void writeBytecode(const std::string& filename, const std::vector<uint8_t>& code, const std::vector<uint8_t>& data, const MetaData& meta, uint8_t word_size, uint32_t flags);
 
     // ==================================================================
     // ======== COMPILER INSTANCE
@@ -370,15 +658,16 @@ namespace ULang {
 
     class CompilerInstance {
         private:
-        std::vector<Token> tokens;  ///< List of all the tokens from the source
         SymbolTable symbols;        ///< Symbol table
         Lexer lexer;                ///< Lexer instance
+        TokenStream tokens;         ///< Tokens pulled from the lexer
 
-        std::vector<ASTPtr> ast_owned;
+        ASTArena ast;               ///< AST node storage
+        ASTList ast_root;           ///< top-level nodes
+        std::unordered_map<const Symbol*, std::vector<Symbol*>> fn_prototypes;  ///< forward declared function -> its parameters
 
         CompilerParameters cparams;
 
-        size_t pos = 0;             ///< Current position
         ASTNode* currentFunction = nullptr; ///< Current function
 
         GenerationContext ctx;
@@ -387,9 +676,10 @@ namespace ULang {
 
         unsigned int verbose_depthLvl = 0;
 
-        void verbose_print(std::string str);
+        // use TRACE_NL/TRACE_PRINT, they skip building the message when not verbose
+        void verbose_print(const std::string& str);
         void verbose_print(int val, int base = 16, int pad_width = 0);
-        void verbose_nl(std::string str, bool ignore_depth = false);
+        void verbose_nl(const std::string& str, bool ignore_depth = false);
         
         inline void verbose_ascend() {
             this->verbose_depthLvl++;
@@ -435,32 +725,74 @@ namespace ULang {
          */
         void friendlyException(CompilerSyntaxException e);
 
+        const DataType* determineBinopType(const DataType* left, const DataType* right);
+
         /**
-         * @brief Get the data type
+         * @brief Warns if two types differ in signedness or size
          * 
+         * @param left first type
+         * @param right second type
+         * @param what message prefix ("Operand types", "Types")
+         * @param loc warning location
+         */
+        void checkOperandTypes(const DataType* left, const DataType* right, const std::string& what, SourceLocation loc);
+
+        /**
+         * @brief Annotates a single node, its children must be annotated already
+         * @exception CompilerSyntaxException
          * @param node node
-         * @param loc source location for logging reference
-         * @return const DataType* 
          */
-        const DataType* getType(ASTNode* node, SourceLocation loc = ULANG_LOCATION_NULL);
+        void annotateType(ASTNode* node);
 
-        const DataType* determineBinopType(const DataType* left, const DataType* right);
+        /**
+         * @brief Annotates the node and its subtree with their types, visiting every node once without recursion
+         * @exception CompilerSyntaxException
+         * @param node node
+         * @return const DataType* type of the node, nullptr if it is made of literals only
+         */
+        const DataType* inferType(ASTNode* node);
+
+        /**
+         * @brief Gives the untyped literal subtrees of an annotated node the type they are used as
+         *
+         * That is the type of the other operand, the declared variable, the assignment target or the
+         * return type of the enclosing function. Literals nothing asks a type of become int32.
+         *
+         * @param node annotated node
+         * @param context type the value of the node is used as, nullptr if none
+         */
+        void contextType(ASTNode* node, const DataType* context);
+
+        /**
+         * @brief Type check pass over the whole AST, run between parsing and code generation
+         * @exception CompilerSyntaxException
+         */
+        void checkTypes();
+
+        /**
+         * @brief Evaluates an expression made of literals only, the way the VM would with the annotated types
+         * 
+         * @param node expression node
+         * @param out value of the expression
+         * @return true if the expression is constant, false if it has to be computed at runtime
+         */
+        bool foldConstant(ASTNode* node, uint64_t& out);
 
         /**
          * @brief Throws an expection if unexcepted token, returns the token if else.
          * @exception std::runtime_error
          * @param type token type
-         * @return const Token& 
+         * @return Token consumed token
          */
-        const Token& expectToken(TokenType type);
+        Token expectToken(TokenType type);
 
         /**
          * @brief Throws an expection if unexcepted token, returns the token if else.
          * @exception std::runtime_error
          * @param type token text
-         * @return const Token& 
+         * @return Token consumed token
          */
-        const Token& expectToken(const std::string& token);
+        Token expectToken(const std::string& token);
 
         bool matchToken(TokenType type);
         bool matchToken(const std::string& token);
@@ -485,10 +817,16 @@ namespace ULang {
         /**
          * @brief parses function declaration
          * @exception std::runtime_error
-         * @return ASTNode* pointer to new AST node
+         * @return ASTNode* pointer to new AST node, nullptr for a forward declaration
          */
         ASTNode* parseFnDecl();
 
+        /**
+         * @brief Rejects a definition that does not match the forward declaration of the function
+         * @exception CompilerSyntaxException always
+         */
+        [[noreturn]] void conflictingFnDecl(const Token& name);
+
         /**
          * @brief parses statement
          * @exception std::runtime_error
@@ -499,17 +837,17 @@ namespace ULang {
         /**
          * @brief parses code block (a sequence of statements)
          * @exception std::runtime_error
-         * @return std::vector<ASTNode*> a vector of pointers to new AST nodes
+         * @return ASTList list of new AST nodes
          */
-        std::vector<ASTNode*> parseBlock();
+        ASTList parseBlock();
 
         /**
-         * @brief parses arithmetical expression
-         * @param prec_min minimal precedence (default: 0)
+         * @brief parses arithmetical expression, with explicit operand and operator stacks so that
+         *        neither long operator chains nor deeply nested parentheses recurse
          * @exception std::runtime_error
          * @return ASTNode* pointer to new AST node
          */
-        ASTNode* parseExpression(int prec_min = 0);
+        ASTNode* parseExpression();
 
         /**
          * @brief Parse function postfix
@@ -531,16 +869,76 @@ namespace ULang {
         Operand makeIMMu32(uint32_t val = 0);
         Operand makeRef(uint32_t offset);
 
+        /**
+         * @brief Makes an operand for the literal, values not fitting the 32-bit immediate go to the constant pool
+         * @param val literal value
+         * @return Operand immediate or constant pool entry (deduplicated)
+         */
+        Operand makeLiteral(uint64_t val);
+
         void serializeInstruction(const Instruction& instr, std::vector<uint8_t>& out);
-        std::vector<uint8_t> serializeProgram(const std::vector<Instruction>& program);
+
+        /**
+         * @brief Serializes the program, resolving branch targets from instruction indices to code offsets
+         * 
+         * @param program instructions
+         * @param offsets code offset of every instruction, plus the end of code
+         * @return std::vector<uint8_t> code section
+         */
+        std::vector<uint8_t> serializeProgram(const std::vector<Instruction>& program, std::vector<uint32_t>& offsets);
 
         Operand compileNode(ASTNode* node, std::vector<Instruction>& out);
+
+        /**
+         * @brief Compiles a tree of binary operators without recursing over it, leaves go through compileNode()
+         * @exception std::runtime_error
+         * @return Operand result, held in the register of the leftmost operand
+         */
+        Operand compileBinop(ASTNode* node, std::vector<Instruction>& out);
         void compileFunction(ASTNode* node, std::vector<Instruction>& out);
 
         void emit(GenerationContext& ctx, Opcode opcode, const Operand& op_a, const Operand& op_b);
 
+        /**
+         * @brief Emits zeroing of a memory range as a bulk MEMSET, extending the previous one if the ranges are adjacent
+         * @param offset range start
+         * @param size range size in bytes
+         */
+        void emitZeroFill(uint32_t offset, uint32_t size);
+
+        /**
+         * @brief Stores a global initializer into the static data image instead of emitting a store
+         * @param offset variable offset
+         * @param size variable size in bytes
+         * @param val value, truncated to size
+         */
+        void emitStaticInit(uint32_t offset, uint32_t size, uint64_t val);
+
+        /**
+         * @brief Builds the SSA form of fn.node (the global code if nullptr), with the same checks as compileNode()
+         * @exception CompilerSyntaxException
+         * @exception std::runtime_error
+         */
+        void buildIR(IRFunction& fn);
+        IRBlock* buildStatementIR(IRFunction& fn, IRBlock* block, ASTNode* node);
+        IRInstr* buildExprIR(IRFunction& fn, IRBlock* block, ASTNode* node);
+
+        /**
+         * @brief Emits the code of an optimized function
+         * @return bool false if it could not be lowered (too many live values), nothing is emitted then
+         */
+        bool lowerIR(IRFunction& fn);
+
+        /**
+         * @brief Compiles a function (the global code if node is nullptr) through the IR and its passes
+         * @exception CompilerSyntaxException
+         * @exception std::runtime_error
+         * @return bool false if the caller has to compile it directly instead
+         */
+        bool compileIR(ASTNode* node, IRPassManager& passes);
+
         public:
-        CompilerInstance(const std::string& source, CompilerParameters& cparams);
+        CompilerInstance(std::string_view source, CompilerParameters& cparams);
 
         /**
          * @brief does the compilation
@@ -16,7 +16,9 @@
 #define ULANG_SYNT_ERR_UNEXCEPTED_RET       (ULANG_SYNT_ERR_BASE + 14)
 #define ULANG_SYNT_ERR_FN_RET_VOID          (ULANG_SYNT_ERR_BASE + 15)
 #define ULANG_SYNT_ERR_INVALID_RET          (ULANG_SYNT_ERR_BASE + 16)
+#define ULANG_SYNT_ERR_FN_UNDEFINED         (ULANG_SYNT_ERR_BASE + 17)
 #define ULANG_SYNT_ERR_MISSING_CLOSE_QUOTE  (ULANG_SYNT_ERR_BASE + 20)
+#define ULANG_SYNT_ERR_LITERAL_RANGE        (ULANG_SYNT_ERR_BASE + 21)
 #define ULANG_SYNT_ERR_BUILTIN_REDECL       (ULANG_SYNT_ERR_BASE + 70)
 
 #define ULANG_SYNT_WARN_TYPES_SIGN_DIFF     (ULANG_SYNT_WARN_BASE + 2)
@@ -1,10 +1,11 @@
 #include "errno.h"
-#include <string>
+#include <cstddef>
+#include <cstdint>
 
 namespace ULang {
     struct SourceLocation {
         void* loc_parent;
-        std::string loc_file;
+        uint32_t loc_file;      ///< interned file id, see sourceFileName()
         size_t loc_line;
         size_t loc_col;
     };
@@ -1,5 +1,6 @@
 #include "compiler.hpp"
 #include <stdexcept>
+#include <vector>
 
 namespace ULang {
     int CompilerInstance::precedence(TokenType type) {
@@ -18,37 +19,48 @@ namespace ULang {
     }
     
     ASTNode* CompilerInstance::parsePrimary() {
-        Token& tok = this->tokens[this->pos];
+        Token tok = this->tokens.peek();
         this->verbose_ascend();
 
-        if(tok.type == TokenType::LParen) {
-            this->pos++;
-            ASTNode* expr = this->parseExpression();
+        if(tok.type == TokenType::Number) {
+            this->tokens.advance();
 
-            this->expectToken(TokenType::RParen);
-            return expr;
-        }
+            // character literal
+            if(tok.text.size() == 3 && tok.text[0] == '\'')
+                return this->ast.make(static_cast<uint64_t>(static_cast<uint32_t>(tok.text[1])));
 
-        if(tok.type == TokenType::Number) {
-            this->pos++;
-            return new ASTNode(std::stoll(tok.text));
+            std::string digits;
+            for(char c: tok.text) {
+                if(c != '_')
+                    digits += c;
+            }
+
+            try {
+                return this->ast.make(static_cast<uint64_t>(std::stoull(digits)));
+            } catch(std::out_of_range&) {
+                throw CompilerSyntaxException(
+                    CompilerSyntaxException::Severity::Error,
+                    "integer literal too large: " + std::string(tok.text),
+                    tok.loc,
+                    ULANG_SYNT_ERR_LITERAL_RANGE
+                );
+            }
         }
 
         if(tok.type == TokenType::Identifier) {
-            this->pos++;
+            this->tokens.advance();
 
             const Symbol* sym = this->symbols.lookup(tok.text);
             if(!sym) {
                 throw CompilerSyntaxException(
                     CompilerSyntaxException::Severity::Error,
-                    "'" + tok.text + "' is not declared in this scope",
+                    "'" + std::string(tok.text) + "' is not declared in this scope",
                     tok.loc,
                     ULANG_SYNT_ERR_VAR_UNDEFINED
                 );
             }
 
-            ASTNode* node = new ASTNode(ASTNodeType::VARIABLE);
-            node->name = tok.text;
+            ASTNode* node = this->ast.make(ASTNodeType::VARIABLE);
             node->symbol = const_cast<Symbol*>(sym);
 
             this->verbose_descend();
@@ -57,7 +69,7 @@ namespace ULang {
 
         SourceLocation loc_fail = {
             nullptr,
-            this->cparams.sourceFile,
+            tok.loc.loc_file,
             static_cast<size_t>(tok.loc.loc_line),
             static_cast<size_t>(tok.loc.loc_col)
         };
@@ -71,101 +83,90 @@ namespace ULang {
         );
     }
 
-    ASTNode* CompilerInstance::parseExpression(int prec_min) {
-        //ASTNode* lefthand = this->parsePrimary();
-        ASTNode* lefthand = this->parsePostfix();
-        if(!lefthand)
-            throw std::runtime_error("parsePostfix() returned nullptr");
+    static BinopType binopType(TokenType op) {
+        switch(op) {
+            case TokenType::Minus:  return BinopType::SUBSTRACTION;
+            case TokenType::Mul:    return BinopType::MULTIPLICATION;
+            case TokenType::Div:    return BinopType::DIVISION;
+            default:                return BinopType::ADDITION;
+        }
+    }
 
-        while(this->pos < this->tokens.size()) {
-            TokenType op = this->tokens[this->pos].type;
-            if(op == TokenType::Semicolon || op == TokenType::EndOfFile || !isBinop(op))
-                break;
+    ASTNode* CompilerInstance::parseExpression() {
+        // operator stack entry, an open parenthesis when paren is set
+        struct PendingOp {
+            TokenType op;
+            int prec;
+            bool paren;
+        };
 
-            int prec = this->precedence(op);
-            if(prec < prec_min)
-                break;
+        std::vector<ASTNode*> operands;
+        std::vector<PendingOp> ops;
+        size_t open_parens = 0;
 
-            this->pos++;
+        auto reduce = [&]() {
+            ASTNode* righthand = operands.back(); operands.pop_back();
+            ASTNode* lefthand  = operands.back(); operands.pop_back();
 
-            ASTNode* righthand = this->parseExpression(prec + 1);
-            if(!lefthand || !righthand) {
-                throw CompilerSyntaxException(
-                    CompilerSyntaxException::Severity::Error,
-                    "Invalid expression operands",
-                    ULANG_LOCATION_NULL,
-                    ULANG_SYNT_ERR_EXCEPTED_EXPR
-                );
+            ASTNode* node = this->ast.make(ASTNodeType::BINOP);
+            node->lefthand = lefthand;
+            node->righthand = righthand;
+            node->op = binopType(ops.back().op);
+
+            ops.pop_back();
+            operands.push_back(node);
+        };
+
+        while(true) {
+            // operand position: opening parentheses, then a postfix expression
+            while(this->tokens.peek().type == TokenType::LParen) {
+                ops.push_back({TokenType::LParen, -1, true});
+                open_parens++;
+                this->tokens.advance();
             }
 
-            //ASTNode* node = new ASTNode(ASTNodeType::BINOP);
-            //node->lefthand = lefthand;
-            //node->righthand = righthand;
+            ASTNode* operand = this->parsePostfix();
+            if(!operand)
+                throw std::runtime_error("parsePostfix() returned nullptr");
 
-            BinopType op_type;
+            operands.push_back(operand);
 
-            switch(op) {
-                case TokenType::Plus:   op_type = BinopType::ADDITION;         break;
-                case TokenType::Minus:  op_type = BinopType::SUBSTRACTION;     break;
-                case TokenType::Mul:    op_type = BinopType::MULTIPLICATION;   break;
-                case TokenType::Div:    op_type = BinopType::DIVISION;         break;
+            // operator position: closing parentheses, then a binary operator or the end of the expression
+            while(open_parens > 0 && this->tokens.peek().type == TokenType::RParen) {
+                while(!ops.back().paren)
+                    reduce();
 
-                default:
-                    break;
+                ops.pop_back();
+                open_parens--;
+                this->tokens.advance();
             }
 
-            if(isBinop(op))
-                this->verbose_nl("IS binop");
-
-            // ---- type checking & BINOP result type ----
-            const DataType* left_type =  getType(lefthand, lefthand->symbol ? lefthand->symbol->where : ULANG_LOCATION_NULL);
-            const DataType* right_type = getType(righthand, righthand->symbol ? righthand->symbol->where : ULANG_LOCATION_NULL);
-            if(!left_type || !right_type)
-                throw std::runtime_error("Could not determine operand types");
-
-            if((left_type->flags & SIGN) != (right_type->flags & SIGN)) {
-                this->friendlyException(CompilerSyntaxException(
-                    CompilerSyntaxException::Severity::Warning,
-                    "Operand types '" + left_type->name + "' and '" + right_type->name + "' differ in signedness",
-                    lefthand->symbol ? lefthand->symbol->where : ULANG_LOCATION_NULL,
-                    ULANG_SYNT_WARN_TYPES_SIGN_DIFF
-                ));
-            }
+            TokenType op = this->tokens.peek().type;
+            if(!isBinop(op))
+                break;
 
-            if(left_type->size != right_type->size) {
-                this->friendlyException(CompilerSyntaxException(
-                    CompilerSyntaxException::Severity::Warning,
-                    "Operand types '" + left_type->name + "' and '" + right_type->name + "' differ in sizes",
-                    lefthand->symbol ? lefthand->symbol->where : ULANG_LOCATION_NULL,
-                    ULANG_SYNT_WARN_TYPES_SIZE_DIFF
-                ));
-            }
+            // left associative, equal precedence reduces first
+            int prec = this->precedence(op);
+            while(!ops.empty() && !ops.back().paren && ops.back().prec >= prec)
+                reduce();
+
+            ops.push_back({op, prec, false});
+            this->tokens.advance();
+        }
 
-            // determine result type (pick larger size, signedness preference)
-            const DataType* result_type = left_type;
-            if(right_type->size > left_type->size) {
-                result_type = right_type;
-            } else if((left_type->flags & SIGN) != (right_type->flags & SIGN)) {
-                result_type = (left_type->flags & SIGN) ? left_type : right_type;
+        while(!ops.empty()) {
+            if(ops.back().paren) {
+                throw CompilerSyntaxException(
+                    CompilerSyntaxException::Severity::Error,
+                    "Unexcepted token: '" + std::string(this->tokens.peek().text) + "', excepted " + toktype2str(TokenType::RParen),
+                    this->tokens.peek().loc,
+                    ULANG_SYNT_ERR_UNEXCEPT_TOK
+                );
             }
 
-            ASTNode* node = new ASTNode(ASTNodeType::BINOP);
-            node->lefthand = lefthand;
-            node->righthand = righthand;
-            node->op = op_type;
-
-            node->symbol = new Symbol{
-                "<binop>", 
-                0, 
-                SymbolKind::VARIABLE, 
-                result_type, 
-                0, 
-                {}
-            };
-
-            lefthand = node;
+            reduce();
         }
 
-        return lefthand;
+        return operands.back();
     }
 };
\ No newline at end of file
@@ -9,34 +9,54 @@ namespace ULang {
 
         // identifier
         Token tok_name = this->expectToken(TokenType::Identifier);
-        
-        Symbol* sym = this->symbols.decl_fn(tok_name.text, ret_type, &tok_name.loc);
 
-        this->verbose_nl("Creating ASTNode for function '" + tok_name.text + "(...)'");
+        // a forward declaration is completed by the definition, which reuses its symbols
+        const Symbol* prior = this->symbols.lookup(tok_name.text);
+        auto proto = this->fn_prototypes.end();
+        if(prior && prior->kind == SymbolKind::FUNCTION && !prior->defined && prior->scope == this->symbols.getCurrentScope()->index)
+            proto = this->fn_prototypes.find(prior);
+
+        Symbol* sym;
+        if(proto != this->fn_prototypes.end()) {
+            if(prior->type != ret_type)
+                this->conflictingFnDecl(tok_name);
+
+            sym = const_cast<Symbol*>(prior);
+        } else sym = this->symbols.decl_fn(std::string(tok_name.text), ret_type, &tok_name.loc);
+
+        TRACE_NL("Creating ASTNode for function '" + std::string(tok_name.text) + "(...)'");
         this->verbose_ascend();
 
-        ASTNode* node = new ASTNode(ASTNodeType::FN_DEF);
-        node->name = tok_name.text;
+        ASTNode* node = this->ast.make(ASTNodeType::FN_DEF);
         node->symbol = sym;
 
         // parameters
+        std::vector<Symbol*> params;
         this->expectToken(TokenType::LParen); 
-        while(this->tokens[this->pos].type != TokenType::RParen) {
+        while(this->tokens.peek().type != TokenType::RParen) {
             // type
             const DataType* arg_type = resolveDataType(this->expectToken(TokenType::TypeKeyword).text);
             
             // identifier
             Token arg_name = this->expectToken(TokenType::Identifier);
 
-            Symbol* arg_sym = this->symbols.decl(arg_name.text, arg_type);
+            Symbol* arg_sym;
+            if(proto != this->fn_prototypes.end()) {
+                const std::vector<Symbol*>& declared = proto->second;
+                if(params.size() >= declared.size() || declared[params.size()]->name != arg_name.text || declared[params.size()]->type != arg_type)
+                    this->conflictingFnDecl(tok_name);
+
+                arg_sym = declared[params.size()];
+            } else arg_sym = this->symbols.decl(std::string(arg_name.text), arg_type);
+
+            params.push_back(arg_sym);
 
-            this->verbose_nl("Creating ASTNode for function parameter '" + tok_name.text + "(...)->" + arg_sym->name + "'");
+            TRACE_NL("Creating ASTNode for function parameter '" + std::string(tok_name.text) + "(...)->" + arg_sym->name + "'");
             
-            ASTNode* arg_node = new ASTNode(ASTNodeType::FN_ARG);
-            arg_node->name = arg_sym->name;
+            ASTNode* arg_node = this->ast.make(ASTNodeType::FN_ARG);
             arg_node->symbol = arg_sym;
 
-            node->args.push_back(arg_node);
+            node->args.push(arg_node);
 
             // continue to next arg if comma, break otherwise
             if(!this->matchToken(TokenType::Comma))
@@ -45,22 +65,23 @@ namespace ULang {
 
         this->expectToken(TokenType::RParen);
 
-        // declaration withou body
+        if(proto != this->fn_prototypes.end() && params.size() != proto->second.size())
+            this->conflictingFnDecl(tok_name);
+
+        // forward declaration, there is nothing to generate
         if(this->matchToken(TokenType::Semicolon)) {
-            this->friendlyException(CompilerSyntaxException(
-                CompilerSyntaxException::Severity::Warning,
-                "Function '" + tok_name.text + "' declaration doesn't define it's body",
-                tok_name.loc,
-                ULANG_SYNT_WARN_FN_NO_BODY
-            ));
+            if(proto == this->fn_prototypes.end())
+                this->fn_prototypes.emplace(sym, std::move(params));
 
             this->verbose_descend();
-            return node;
+            return nullptr;
         }
 
-        std::string scopeName = this->symbols.getCurrentScope()->_name + "::" + tok_name.text + "@fn_decl";
+        sym->defined = true;
+
+        std::string scopeName = this->symbols.getCurrentScope()->_name + "::" + std::string(tok_name.text) + "@fn_decl";
         Scope* fn_scope = this->symbols.enter(scopeName);
-        this->verbose_nl("Enter new scope: " + fn_scope->_name);
+        TRACE_NL("Enter new scope: " + fn_scope->_name);
 
         // function body
         // ! function MUST have code block unlike if-else statements, etc
@@ -71,18 +92,27 @@ namespace ULang {
         return node;
     }
 
+    void CompilerInstance::conflictingFnDecl(const Token& name) {
+        throw CompilerSyntaxException(
+            CompilerSyntaxException::Severity::Error,
+            "conflicting declaration of function '" + std::string(name.text) + "'",
+            name.loc,
+            ULANG_SYNT_ERR_FN_REDEFINE
+        );
+    }
+
     ASTNode* CompilerInstance::parsePostfix() {
         ASTNode* node = this->parsePrimary();
 
-        while(this->pos < this->tokens.size()) {
+        while(true) {
             /*
             if(this->tokens[this->pos].type == TokenType::LParen) {
                 if(!node->symbol) {
-                    const Symbol* sym = this->symbols.lookup(node->name);
+                    const Symbol* sym = this->symbols.lookup(node->name());
                     if(!sym) {
                         throw CompilerSyntaxException(
                             CompilerSyntaxException::Severity::Error,
-                            "'" + node->name + "' was not declared in current scope",
+                            "'" + node->name() + "' was not declared in current scope",
                             node->symbol->where,
                             ULANG_SYNT_ERR_VAR_UNDEFINED
                         );
@@ -92,14 +122,14 @@ namespace ULang {
                     if(node->symbol->kind != SymbolKind::FUNCTION) {
                         throw CompilerSyntaxException(
                             CompilerSyntaxException::Severity::Error,
-                            "'" + node->name + "' is not a function",
+                            "'" + node->name() + "' is not a function",
                             node->symbol->where,
                             ULANG_SYNT_ERR_FN_NOT_FN
                         );
                     }
                 }
 
-                ASTNode* call = new ASTNode(ASTNodeType::FN_CALL);
+                ASTNode* call = this->ast.make(ASTNodeType::FN_CALL);
                 call->lefthand = node;
 
                 this->pos++;
@@ -107,7 +137,7 @@ namespace ULang {
                 if(this->tokens[this->pos].type != TokenType::RParen) {
                     do {
                         ASTNode* arg = parseExpression();
-                        call->args.push_back(arg);
+                        call->args.push(arg);
 
                         if(this->tokens[this->pos].type != TokenType::Comma) 
                             break;
@@ -121,7 +151,7 @@ namespace ULang {
                 if(node->symbol->kind != SymbolKind::FUNCTION) {
                     throw CompilerSyntaxException(
                         CompilerSyntaxException::Severity::Error,
-                        "'" + node->name + "' is not a function",
+                        "'" + node->name() + "' is not a function",
                         node->symbol->where,
                         ULANG_SYNT_ERR_FN_NOT_FN
                     );
@@ -134,15 +164,15 @@ namespace ULang {
             break;
             */
 
-            if(this->tokens[this->pos].type != TokenType::LParen)
+            if(this->tokens.peek().type != TokenType::LParen)
                 break;
 
-            if(node->name.empty() || !node->symbol) {
+            if(!node->symbol) {
                 /*
                 if(node->symbol->kind != SymbolKind::FUNCTION) {
                     throw CompilerSyntaxException(
                         CompilerSyntaxException::Severity::Error,
-                        "'" + node->name + "' is not a function",
+                        "'" + node->name() + "' is not a function",
                         node->symbol->where,
                         ULANG_SYNT_ERR_FN_NOT_FN
                     );
@@ -156,28 +186,28 @@ namespace ULang {
                 if(node->symbol->kind != SymbolKind::FUNCTION) {
                     throw CompilerSyntaxException(
                         CompilerSyntaxException::Severity::Error,
-                        "'" + node->name + "' is not a function",
+                        "'" + node->name() + "' is not a function",
                         node->symbol->where,
                         ULANG_SYNT_ERR_FN_NOT_FN
                     );
                 }
             }
 
-            ASTNode* call_node = new ASTNode(ASTNodeType::FN_CALL);
+            ASTNode* call_node = this->ast.make(ASTNodeType::FN_CALL);
             call_node->lefthand = node;
             call_node->symbol = node->symbol;
-            this->pos++;
+            this->tokens.advance();
 
-            if(this->tokens[this->pos].type != TokenType::RParen) {
+            if(this->tokens.peek().type != TokenType::RParen) {
                 do {
-                    //ASTNode* arg_node = new ASTNode(ASTNodeType::FN_ARG);
+                    //ASTNode* arg_node = this->ast.make(ASTNodeType::FN_ARG);
                     ASTNode* arg_node = this->parseExpression();
-                    call_node->args.push_back(arg_node);
+                    call_node->args.push(arg_node);
 
-                    if(this->tokens[this->pos].type != TokenType::Comma)
+                    if(this->tokens.peek().type != TokenType::Comma)
                         break;
 
-                    this->pos++;
+                    this->tokens.advance();
                 } while(true);
             }
 
@@ -7,7 +7,7 @@
 #include <vector>
 
 #define cout_verbose        \
-    if(this->cparams.verbose)    \
+    if(ULANG_TRACE_ENABLED && this->cparams.verbose)    \
         std::cout
 
 namespace ULang {
@@ -18,16 +18,16 @@ namespace ULang {
             if(n->type != ASTNodeType::FN_DEF)
                 continue;
 
-            if(this->symbols.lookup(n->name)) {
+            if(this->symbols.lookup(n->name())) {
                 throw CompilerSyntaxException(
                     CompilerSyntaxException::Severity::Error,
-                    "redefinition of '" + n->name + "' (function)",
+                    "redefinition of '" + n->name() + "' (function)",
                     n->symbol ? n->symbol->where : ULANG_LOCATION_NULL,
                     ULANG_SYNT_ERR_FN_REDEFINE
                 );
             }
 
-            Symbol* sym = this->symbols.decl(n->name, &TYPE_VOID, nullptr);
+            Symbol* sym = this->symbols.decl(n->name(), &TYPE_VOID, nullptr);
             sym->kind = SymbolKind::FUNCTION;
             sym->entry_ip = static_cast<uint32_t>(-1); // TODO: entry ip
             
@@ -41,13 +41,13 @@ namespace ULang {
             throw std::runtime_error("function symbol not found");
 
         node->symbol->entry_ip = out.size();
-        this->verbose_nl("Compile function '" + node->symbol->name + "', entry_ip=");
-        this->verbose_print(node->symbol->entry_ip);
+        TRACE_NL("Compile function '" + node->symbol->name + "', entry_ip=");
+        TRACE_PRINT(node->symbol->entry_ip);
         this->verbose_ascend();
 
-        std::string scope_name = this->symbols.getCurrentScope()->_name + "::" + node->name + "@fn_decl";
+        std::string scope_name = this->symbols.getCurrentScope()->_name + "::" + node->name() + "@fn_decl";
         this->symbols.enter(scope_name);
-        this->verbose_nl("Enter scope: " + scope_name);
+        TRACE_NL("Enter scope: " + scope_name);
 
         for(ASTNode* stmt: node->body)
             this->compileNode(stmt, out);
@@ -56,12 +56,16 @@ namespace ULang {
         if(node->symbol->type != &TYPE_VOID && !termRet) {
             throw CompilerSyntaxException(
                 CompilerSyntaxException::Severity::Error,
-                "non-void function must return a value: '" + node->name + "'",
+                "non-void function must return a value: '" + node->name() + "'",
                 node->symbol->where,
                 ULANG_SYNT_ERR_FN_NO_RET
             );
         }
 
+        // void function falling off its end
+        if(!termRet)
+            this->emit(this->ctx, Opcode::RET, {OperandType::OP_NULL, 0}, {OperandType::OP_NULL, 0});
+
         this->verbose_descend();
     }
 };
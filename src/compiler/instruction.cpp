@@ -30,6 +30,23 @@ namespace ULang {
         return this->makeIMM(val);
     }
 
+    Operand CompilerInstance::makeLiteral(uint64_t val) {
+        if(val <= UINT32_MAX)
+            return this->makeIMM(static_cast<uint32_t>(val));
+
+        auto it = this->ctx.const_index.find(val);
+        if(it == this->ctx.const_index.end()) {
+            it = this->ctx.const_index.emplace(val, this->ctx.constants.size()).first;
+            this->ctx.constants.push_back(val);
+        }
+
+        Operand o{};
+        o.type = OperandType::OP_CONSTANT;
+        o.data = it->second;
+
+        return o;
+    }
+
     Operand CompilerInstance::makeRef(uint32_t offset) {
         Operand o{};
 
@@ -0,0 +1,254 @@
+#include "compiler/ir.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+namespace ULang {
+    bool IRInstr::isPure() const {
+        switch(this->op) {
+            case IROp::CONST:
+            case IROp::LOAD:
+                return true;
+
+            case IROp::BINOP:
+                break;
+
+            default:
+                return false;
+        }
+
+        // divisions fault on zero (and signed ones on MIN / -1), keep them unless the divisor is known to be safe
+        const IRInstr* divisor = this->args[1];
+        bool known = divisor->op == IROp::CONST;
+
+        switch(this->opcode) {
+            case Opcode::DIV:       return known && divisor->imm != 0;
+            case Opcode::DIV32:     return known && uint32_t(divisor->imm) != 0;
+            case Opcode::IDIV:      return known && divisor->imm != 0 && divisor->imm != UINT64_MAX;
+            case Opcode::IDIV32:    return known && uint32_t(divisor->imm) != 0 && uint32_t(divisor->imm) != UINT32_MAX;
+            default:                return true;
+        }
+    }
+
+    // constants are shared by the whole function, their user lists would only grow
+    void IRInstr::addUser(IRInstr* user) {
+        if(this->op != IROp::CONST)
+            this->users.push_back(user);
+    }
+
+    void IRInstr::dropUser(IRInstr* user) {
+        if(this->op == IROp::CONST)
+            return;
+
+        // the users removed are mostly the recent ones
+        auto it = std::find(this->users.rbegin(), this->users.rend(), user);
+        if(it != this->users.rend())
+            this->users.erase(std::next(it).base());
+    }
+
+    IRBlock* IRFunction::newBlock() {
+        IRBlock& block = this->block_pool.emplace_back();
+        block.id = static_cast<uint32_t>(this->blocks.size());
+
+        this->blocks.push_back(&block);
+        return &block;
+    }
+
+    IRInstr* IRFunction::append(IRBlock* block, IROp op, std::vector<IRInstr*> args) {
+        IRInstr& instr = this->instr_pool.emplace_back();
+        instr.op = op;
+        instr.id = static_cast<uint32_t>(this->instr_pool.size() - 1);
+        instr.block = block;
+        instr.args = std::move(args);
+
+        for(IRInstr* arg: instr.args)
+            arg->addUser(&instr);
+
+        if(block)
+            block->instrs.push_back(&instr);
+
+        return &instr;
+    }
+
+    IRInstr* IRFunction::constant(uint64_t val) {
+        auto it = this->const_pool.find(val);
+        if(it != this->const_pool.end())
+            return it->second;
+
+        IRInstr* instr = this->append(nullptr, IROp::CONST);
+        instr->imm = val;
+
+        this->const_pool.emplace(val, instr);
+        return instr;
+    }
+
+    void IRFunction::replaceAllUses(IRInstr* from, IRInstr* to) {
+        if(from == to)
+            return;
+
+        for(IRInstr* user: from->users) {
+            for(IRInstr*& arg: user->args) {
+                if(arg == from)
+                    arg = to;
+            }
+        }
+
+        // a user appears once per operand, so it moves over as many times as it used from
+        for(IRInstr* user: from->users)
+            to->addUser(user);
+
+        from->users.clear();
+    }
+
+    void IRFunction::erase(IRInstr* instr) {
+        if(!instr->users.empty())
+            throw std::runtime_error("IR: erasing a value that is still used");
+
+        for(IRInstr* arg: instr->args)
+            arg->dropUser(instr);
+
+        instr->args.clear();
+        instr->dead = true;
+
+        // unused constants stay in the pool, they are free
+    }
+
+    void IRFunction::compact() {
+        for(IRBlock* block: this->blocks) {
+            block->instrs.erase(
+                std::remove_if(block->instrs.begin(), block->instrs.end(), [](IRInstr* i) {return i->dead;}),
+                block->instrs.end()
+            );
+        }
+    }
+
+    static const char* irOpName(IROp op) {
+        switch(op) {
+            case IROp::CONST:   return "const";
+            case IROp::LOAD:    return "load";
+            case IROp::STORE:   return "store";
+            case IROp::ZERO:    return "zero";
+            case IROp::BINOP:   return "binop";
+            case IROp::CALL:    return "call";
+            case IROp::RET:     return "ret";
+            case IROp::HALT:    return "halt";
+        }
+
+        return "?";
+    }
+
+    std::string IRFunction::dump() const {
+        std::ostringstream out;
+        out << "ir " << this->name << ":";
+
+        for(const IRBlock* block: this->blocks) {
+            out << "\n  bb" << block->id << ":";
+
+            for(const IRInstr* instr: block->instrs) {
+                out << "\n    ";
+                if(!instr->users.empty())
+                    out << "%" << instr->id << " = ";
+
+                out << irOpName(instr->op);
+                if(instr->op == IROp::LOAD || instr->op == IROp::STORE || instr->op == IROp::BINOP)
+                    out << "." << opcodeToStr(instr->opcode);
+                if(instr->op == IROp::LOAD || instr->op == IROp::STORE || instr->op == IROp::ZERO)
+                    out << " &" << std::hex << instr->slot << std::dec << ":" << instr->size;
+                if(instr->op == IROp::CALL)
+                    out << " " << instr->callee->name;
+
+                for(const IRInstr* arg: instr->args) {
+                    if(arg->op == IROp::CONST)
+                        out << " " << arg->imm;
+                    else out << " %" << arg->id;
+                }
+            }
+        }
+
+        return out.str();
+    }
+
+    size_t IRPassManager::run(IRFunction& fn) {
+        size_t changes = 0;
+
+        for(int round = 0; round < ULANG_IR_MAX_ROUNDS; round++) {
+            bool changed = false;
+
+            for(const std::unique_ptr<IRPass>& pass: this->passes) {
+                if(pass->run(fn)) {
+                    changed = true;
+                    changes++;
+                }
+
+                fn.compact();
+            }
+
+            if(!changed)
+                break;
+        }
+
+        return changes;
+    }
+
+    bool evalBinop(Opcode opcode, uint64_t a, uint64_t b, uint64_t& out) {
+        switch(opcode) {
+            case Opcode::ADD:   out = a + b; return true;
+            case Opcode::SUB:   out = a - b; return true;
+            case Opcode::MUL:   out = a * b; return true;
+
+            case Opcode::DIV:
+                if(b == 0) return false;
+                out = a / b;
+                return true;
+
+            case Opcode::IDIV:
+                if(b == 0 || (int64_t(a) == INT64_MIN && int64_t(b) == -1)) return false;
+                out = uint64_t(int64_t(a) / int64_t(b));
+                return true;
+
+            case Opcode::ADD32: out = uint32_t(uint32_t(a) + uint32_t(b)); return true;
+            case Opcode::SUB32: out = uint32_t(uint32_t(a) - uint32_t(b)); return true;
+            case Opcode::MUL32: out = uint32_t(uint32_t(a) * uint32_t(b)); return true;
+
+            case Opcode::IADD32: out = uint64_t(int64_t(int32_t(uint32_t(a) + uint32_t(b)))); return true;
+            case Opcode::ISUB32: out = uint64_t(int64_t(int32_t(uint32_t(a) - uint32_t(b)))); return true;
+            case Opcode::IMUL32: out = uint64_t(int64_t(int32_t(uint32_t(a) * uint32_t(b)))); return true;
+
+            case Opcode::DIV32:
+                if(uint32_t(b) == 0) return false;
+                out = uint32_t(a) / uint32_t(b);
+                return true;
+
+            case Opcode::IDIV32:
+                if(uint32_t(b) == 0 || (int32_t(a) == INT32_MIN && int32_t(b) == -1)) return false;
+                out = uint64_t(int64_t(int32_t(a) / int32_t(b)));
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    uint32_t accessSize(Opcode opcode) {
+        switch(opcode) {
+            case Opcode::LD8:  case Opcode::LD8S:  case Opcode::ST8:  return 1;
+            case Opcode::LD16: case Opcode::LD16S: case Opcode::ST16: return 2;
+            case Opcode::LD32: case Opcode::LD32S: case Opcode::ST32: return 4;
+            default:                                                   return 8;
+        }
+    }
+
+    uint64_t evalLoad(Opcode opcode, uint64_t val) {
+        switch(opcode) {
+            case Opcode::LD8:   return uint8_t(val);
+            case Opcode::LD16:  return uint16_t(val);
+            case Opcode::LD32:  return uint32_t(val);
+            case Opcode::LD8S:  return uint64_t(int64_t(int8_t(val)));
+            case Opcode::LD16S: return uint64_t(int64_t(int16_t(val)));
+            case Opcode::LD32S: return uint64_t(int64_t(int32_t(val)));
+            default:            return val;
+        }
+    }
+};
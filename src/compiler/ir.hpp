@@ -0,0 +1,193 @@
+#ifndef __ULANG_IR_H
+#define __ULANG_IR_H
+
+#include "bytecode.hpp"
+#include "compiler/compiler.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ULang {
+    // ==================================================================
+    // ======== SSA INTERMEDIATE REPRESENTATION
+    // ==================================================================
+
+    /*
+     * Variables live in memory (heap slots addressed by their symbol's offset), every other value
+     * is defined exactly once by the instruction that computes it. Instructions refer to their
+     * operands directly and keep the list of their users, so the def-use chains are always at hand.
+     */
+
+    enum class IROp {
+        CONST,      ///< literal value
+        LOAD,       ///< value of a heap slot
+        STORE,      ///< heap slot = args[0]
+        ZERO,       ///< zero fill of a heap range
+        BINOP,      ///< args[0] <opcode> args[1]
+        CALL,       ///< call, the value is what the callee returned
+        RET,        ///< return args[0] if any, terminator
+        HALT,       ///< end of the global code, terminator
+    };
+
+    struct IRBlock;
+
+    struct IRInstr {
+        IROp op;
+        Opcode opcode = Opcode::NOP;    ///< LOAD/STORE/BINOP: instruction it lowers to, defines the exact semantics
+        uint32_t id;                    ///< value number, for dumps
+
+        uint64_t imm = 0;               ///< CONST: value
+        uint32_t slot = 0;              ///< LOAD/STORE/ZERO: heap offset
+        uint32_t size = 0;              ///< LOAD/STORE/ZERO: bytes
+        Symbol* callee = nullptr;       ///< CALL: function
+
+        std::vector<IRInstr*> args;     ///< operands
+        std::vector<IRInstr*> users;    ///< instructions using this value, once per operand, not kept for CONST
+
+        IRBlock* block = nullptr;       ///< nullptr for CONST
+        bool dead = false;              ///< removed, dropped from the block on the next compaction
+
+        bool isTerminator() const {return this->op == IROp::RET || this->op == IROp::HALT;};
+
+        /**
+         * @brief Whether removing the instruction cannot change what the program does (other than get faster)
+         */
+        bool isPure() const;
+
+        void addUser(IRInstr* user);
+        void dropUser(IRInstr* user);
+    };
+
+    struct IRBlock {
+        uint32_t id;
+        std::vector<IRInstr*> instrs;
+        std::vector<IRBlock*> preds;
+        std::vector<IRBlock*> succs;
+
+        bool terminated() const {return !this->instrs.empty() && this->instrs.back()->isTerminator();};
+    };
+
+    /**
+     * @brief A function, or the global code, in SSA form. Owns its blocks and instructions.
+     */
+    class IRFunction {
+        private:
+        std::deque<IRInstr> instr_pool;     ///< never moves, instructions point at each other
+        std::deque<IRBlock> block_pool;
+        std::unordered_map<uint64_t, IRInstr*> const_pool;  ///< value -> CONST
+
+        public:
+        std::string name;
+        ASTNode* node = nullptr;            ///< FN_DEF, nullptr for the global code
+        std::vector<IRBlock*> blocks;       ///< blocks[0] is the entry
+        std::vector<CompilerSyntaxException> warnings;  ///< reported once the function is emitted from the IR
+
+        IRBlock* newBlock();
+
+        /**
+         * @brief Appends an instruction to the end of block
+         * @return IRInstr* instruction, linked into the users of its operands
+         */
+        IRInstr* append(IRBlock* block, IROp op, std::vector<IRInstr*> args = {});
+
+        /**
+         * @brief Returns the CONST of a value, there is one per value and it belongs to no block
+         */
+        IRInstr* constant(uint64_t val);
+
+        /**
+         * @brief Makes every user of from use to instead
+         */
+        void replaceAllUses(IRInstr* from, IRInstr* to);
+
+        /**
+         * @brief Marks an unused instruction dead and unlinks it from its operands
+         * @exception std::runtime_error if the instruction still has users
+         */
+        void erase(IRInstr* instr);
+
+        /**
+         * @brief Drops dead instructions from the blocks
+         */
+        void compact();
+
+        std::string dump() const;
+    };
+
+    /**
+     * @brief Transformation of a single function
+     */
+    class IRPass {
+        public:
+        virtual ~IRPass() = default;
+
+        virtual const char* name() const = 0;
+
+        /**
+         * @brief Runs the pass
+         * @return bool whether the function changed
+         */
+        virtual bool run(IRFunction& fn) = 0;
+    };
+
+    /**
+     * @brief Forwards stored and loaded slot values to later loads, folds constant operations
+     * and merges equal ones (within a block, memory is forgotten across calls)
+     */
+    class IRValueNumbering: public IRPass {
+        public:
+        const char* name() const override {return "value-numbering";};
+        bool run(IRFunction& fn) override;
+    };
+
+    /**
+     * @brief Removes unreachable blocks, unused pure values and stores overwritten before anything reads them
+     */
+    class IRDeadCode: public IRPass {
+        public:
+        const char* name() const override {return "dead-code";};
+        bool run(IRFunction& fn) override;
+    };
+
+#define ULANG_IR_MAX_ROUNDS 4   ///< pass pipeline repetitions until nothing changes
+
+    class IRPassManager {
+        private:
+        std::vector<std::unique_ptr<IRPass>> passes;
+
+        public:
+        void add(std::unique_ptr<IRPass> pass) {this->passes.push_back(std::move(pass));};
+
+        /**
+         * @brief Runs the passes in order, repeatedly until none of them changes anything
+         * @return size_t number of pass runs that changed the function
+         */
+        size_t run(IRFunction& fn);
+    };
+
+    /**
+     * @brief Bytes a load or store opcode accesses
+     */
+    uint32_t accessSize(Opcode opcode);
+
+    Opcode loadOpcode(const DataType* type);
+    Opcode storeOpcode(const DataType* type);
+    Opcode binopOpcode(BinopType op, const DataType* type);
+
+    /**
+     * @brief Evaluates a binary opcode exactly as the VM does
+     * @return bool false if it would fault at runtime (division by zero, overflow)
+     */
+    bool evalBinop(Opcode opcode, uint64_t a, uint64_t b, uint64_t& out);
+
+    /**
+     * @brief Value a load opcode produces from a slot that holds val
+     */
+    uint64_t evalLoad(Opcode opcode, uint64_t val);
+};
+
+#endif
@@ -0,0 +1,234 @@
+#include "compiler/compiler.hpp"
+#include "compiler/errno.h"
+#include "compiler/ir.hpp"
+#include "types.hpp"
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace ULang {
+    void CompilerInstance::buildIR(IRFunction& fn) {
+        ASTNode* prev = this->currentFunction;
+        this->currentFunction = fn.node;
+
+        IRBlock* block = fn.newBlock();
+
+        if(!fn.node) {
+            for(ASTNode* node: this->ast_root) {
+                if(node->type != ASTNodeType::FN_DEF)
+                    block = this->buildStatementIR(fn, block, node);
+            }
+
+            if(block->terminated())
+                block = fn.newBlock();
+
+            fn.append(block, IROp::HALT);
+            this->currentFunction = prev;
+            return;
+        }
+
+        if(!fn.node->symbol)
+            throw std::runtime_error("function symbol not found");
+
+        for(ASTNode* stmt: fn.node->body)
+            block = this->buildStatementIR(fn, block, stmt);
+
+        bool termRet = !fn.node->body.empty() && fn.node->body.back()->type == ASTNodeType::FN_RET;
+        if(fn.node->symbol->type != &TYPE_VOID && !termRet) {
+            throw CompilerSyntaxException(
+                CompilerSyntaxException::Severity::Error,
+                "non-void function must return a value: '" + fn.node->name() + "'",
+                fn.node->symbol->where,
+                ULANG_SYNT_ERR_FN_NO_RET
+            );
+        }
+
+        // void function falling off its end
+        if(!termRet)
+            fn.append(block, IROp::RET);
+
+        this->currentFunction = prev;
+    }
+
+    IRBlock* CompilerInstance::buildStatementIR(IRFunction& fn, IRBlock* block, ASTNode* node) {
+        if(!node)
+            return block;
+
+        // nothing branches yet, code after a return starts a block no one reaches
+        if(block->terminated())
+            block = fn.newBlock();
+
+        switch(node->type) {
+            case ASTNodeType::DECLARATION: {
+                if(node->initial) {
+                    IRInstr* val = this->buildExprIR(fn, block, node->initial);
+                    IRInstr* instr = fn.append(block, IROp::STORE, {val});
+                    instr->opcode = storeOpcode(node->symbol->type);
+                    instr->slot = node->symbol->stackOffset;
+                    instr->size = accessSize(instr->opcode);
+                } else if(this->cparams.OExplicitZero) {
+                    IRInstr* instr = fn.append(block, IROp::ZERO);
+                    instr->slot = node->symbol->stackOffset;
+                    instr->size = node->symbol->type->size;
+                }
+
+                return block;
+            }
+
+            case ASTNodeType::ASSIGNMENT: {
+                IRInstr* val = this->buildExprIR(fn, block, node->righthand);
+                if(!node->lefthand || !node->lefthand->symbol)
+                    throw std::runtime_error("Assignment target missing");
+
+                IRInstr* instr = fn.append(block, IROp::STORE, {val});
+                instr->opcode = storeOpcode(node->lefthand->symbol->type);
+                instr->slot = node->lefthand->symbol->stackOffset;
+                instr->size = accessSize(instr->opcode);
+                return block;
+            }
+
+            case ASTNodeType::FN_RET: {
+                if(!this->currentFunction) {
+                    throw CompilerSyntaxException(
+                        CompilerSyntaxException::Severity::Error,
+                        "return statement not excepted",
+                        node->symbol ? node->symbol->where : ULANG_LOCATION_NULL,
+                        ULANG_SYNT_ERR_UNEXCEPTED_RET
+                    );
+                }
+
+                const DataType* ret_type = this->currentFunction->symbol->type;
+
+                if(!node->initial) {
+                    if(ret_type != &TYPE_VOID) {
+                        throw CompilerSyntaxException(
+                            CompilerSyntaxException::Severity::Error,
+                            "non-void function must return a value: '" + node->name() + "'",
+                            this->currentFunction->symbol->where,
+                            ULANG_SYNT_ERR_FN_NO_RET
+                        );
+                    }
+
+                    fn.append(block, IROp::RET);
+                    return block;
+                }
+
+                if(ret_type == &TYPE_VOID) {
+                    throw CompilerSyntaxException(
+                        CompilerSyntaxException::Severity::Error,
+                        "void function can't return a value",
+                        this->currentFunction->symbol->where,
+                        ULANG_SYNT_ERR_FN_RET_VOID
+                    );
+                }
+
+                const DataType* retExpr_type = node->initial->value_type;
+                if(retExpr_type && retExpr_type != ret_type) {
+                    throw CompilerSyntaxException(
+                        CompilerSyntaxException::Severity::Error,
+                        "return type mismatch",
+                        this->currentFunction->symbol->where,
+                        ULANG_SYNT_ERR_INVALID_RET
+                    );
+                }
+
+                fn.append(block, IROp::RET, {this->buildExprIR(fn, block, node->initial)});
+                return block;
+            }
+
+            case ASTNodeType::FN_ARG:
+                return block;
+
+            case ASTNodeType::FN_DEF:
+                throw std::runtime_error("nested function definition: '" + node->name() + "'");
+
+            default:
+                // expression statement, only its side effects matter
+                this->buildExprIR(fn, block, node);
+                return block;
+        }
+    }
+
+    IRInstr* CompilerInstance::buildExprIR(IRFunction& fn, IRBlock* block, ASTNode* node) {
+        // post-order walk on explicit stacks, like compileBinop()
+        std::vector<std::pair<ASTNode*, bool>> stack = {{node, false}};
+        std::vector<IRInstr*> values;
+
+        while(!stack.empty()) {
+            auto [n, children_done] = stack.back();
+            stack.pop_back();
+
+            switch(n->type) {
+                case ASTNodeType::NUMBER:
+                    values.push_back(fn.constant(n->val));
+                    continue;
+
+                case ASTNodeType::VARIABLE: {
+                    if(!n->symbol) {
+                        throw CompilerSyntaxException(
+                            CompilerSyntaxException::Severity::Error,
+                            "Undefined variable: " + n->name(),
+                            ULANG_LOCATION_NULL,
+                            ULANG_SYNT_ERR_VAR_UNDEFINED
+                        );
+                    }
+
+                    IRInstr* load = fn.append(block, IROp::LOAD);
+                    load->opcode = loadOpcode(n->symbol->type);
+                    load->slot = n->symbol->stackOffset;
+                    load->size = accessSize(load->opcode);
+
+                    values.push_back(load);
+                    continue;
+                }
+
+                case ASTNodeType::FN_CALL: {
+                    if(!n->symbol)
+                        throw std::runtime_error("function symbol not set for FN_CALL: '" + n->name() + "'");
+                    if(n->symbol->kind != SymbolKind::FUNCTION)
+                        throw std::runtime_error("invalid symbol in FN_CALL: '" + n->name() + "'");
+
+                    // arguments are evaluated only for their side effects, as compileNode() does
+                    for(ASTNode* arg: n->args)
+                        this->buildStatementIR(fn, block, arg);
+
+                    IRInstr* call = fn.append(block, IROp::CALL);
+                    call->callee = n->symbol;
+
+                    values.push_back(call);
+                    continue;
+                }
+
+                case ASTNodeType::BINOP:
+                    break;
+
+                default:
+                    throw std::runtime_error("invalid AST node type");
+            }
+
+            if(!children_done) {
+                stack.push_back({n, true});
+                stack.push_back({n->righthand, false});
+                stack.push_back({n->lefthand, false});
+                continue;
+            }
+
+            IRInstr* R = values.back(); values.pop_back();
+            IRInstr* L = values.back(); values.pop_back();
+
+            if(n->op == BinopType::DIVISION && n->righthand->type == ASTNodeType::NUMBER && n->righthand->val == 0) {
+                fn.warnings.push_back(CompilerSyntaxException(
+                    CompilerSyntaxException::Severity::Warning,
+                    "Division by zero", ULANG_LOCATION_NULL,
+                    ULANG_SYNT_WARN_DIVISION_ZERO
+                ));
+            }
+
+            IRInstr* instr = fn.append(block, IROp::BINOP, {L, R});
+            instr->opcode = binopOpcode(n->op, n->value_type);
+            values.push_back(instr);
+        }
+
+        return values.back();
+    }
+};
@@ -0,0 +1,240 @@
+#include "bytecode.hpp"
+#include "compiler/compiler.hpp"
+#include "compiler/ir.hpp"
+#include "vmreg_defines.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ULang {
+    struct PendingInit {
+        uint32_t offset;
+        uint32_t size;
+        uint64_t val;
+    };
+
+    bool CompilerInstance::lowerIR(IRFunction& fn) {
+        // no branches to emit yet
+        if(fn.blocks.size() != 1)
+            return false;
+
+        const std::vector<IRInstr*>& instrs = fn.blocks[0]->instrs;
+        std::vector<Instruction>& code = this->ctx.instructions;
+
+        size_t code_mark = code.size();
+        size_t fixup_mark = this->ctx.call_fixups.size();
+
+        // TMP0 is left out, divisions write the remainder there
+        const std::vector<uint32_t> pool = {
+            R_GPR0A.reg_no, R_GPR0B.reg_no, R_GPR0C.reg_no, R_GPR0D.reg_no,
+            R_GPR1A.reg_no, R_GPR1B.reg_no, R_GPR1C.reg_no, R_GPR1D.reg_no,
+            R_TMP1.reg_no, R_TMP2.reg_no, R_TMP3.reg_no
+        };
+        const size_t fnr = pool.size();                 ///< holder index of FNR, where calls leave their value
+
+        std::vector<IRInstr*> holder(pool.size() + 1, nullptr);
+        std::unordered_map<const IRInstr*, size_t> where;   ///< value -> holder index
+        std::unordered_map<const IRInstr*, size_t> last_use;
+
+        for(size_t i = 0; i < instrs.size(); i++) {
+            for(IRInstr* arg: instrs[i]->args)
+                last_use[arg] = i;
+        }
+
+        auto reg = [&](size_t idx) -> Operand {
+            return {OperandType::OP_REGISTER, idx == fnr ? R_FNR.reg_no : pool[idx]};
+        };
+
+        auto alloc = [&]() -> size_t {
+            for(size_t idx = 0; idx < pool.size(); idx++) {
+                if(!holder[idx])
+                    return idx;
+            }
+
+            return SIZE_MAX;
+        };
+
+        auto operand = [&](const IRInstr* v) -> Operand {
+            if(v->op == IROp::CONST)
+                return this->makeLiteral(v->imm);
+
+            return reg(where.at(v));
+        };
+
+        auto hold = [&](IRInstr* v, size_t idx) {
+            if(v->users.empty())
+                return;
+
+            holder[idx] = v;
+            where[v] = idx;
+        };
+
+        auto release = [&](const IRInstr* v, size_t i) {
+            auto it = where.find(v);
+            if(it == where.end() || last_use[v] > i)
+                return;
+
+            holder[it->second] = nullptr;
+            where.erase(it);
+        };
+
+        // the global code runs once: constant stores nothing could have observed yet go to the data section
+        bool global = !fn.node;
+        bool called = false;
+        std::vector<bool> touched;
+        std::vector<PendingInit> inits;
+
+        auto touch = [&](uint32_t offset, uint32_t size) -> bool {
+            if(touched.size() < offset + size)
+                touched.resize(offset + size, false);
+
+            bool was = false;
+            for(uint32_t b = offset; b < offset + size; b++) {
+                was = was || touched[b];
+                touched[b] = true;
+            }
+
+            return was;
+        };
+
+        for(size_t i = 0; i < instrs.size(); i++) {
+            IRInstr* instr = instrs[i];
+
+            switch(instr->op) {
+                case IROp::CONST:
+                    break;
+
+                case IROp::LOAD: {
+                    size_t dst = alloc();
+                    if(dst == SIZE_MAX)
+                        goto bail;
+
+                    touch(instr->slot, instr->size);
+                    this->emit(this->ctx, instr->opcode, reg(dst), this->makeRef(instr->slot));
+                    hold(instr, dst);
+                    break;
+                }
+
+                case IROp::STORE: {
+                    IRInstr* val = instr->args[0];
+                    bool seen = touch(instr->slot, instr->size);
+
+                    if(global && !called && !seen && val->op == IROp::CONST) {
+                        inits.push_back({instr->slot, instr->size, val->imm});
+                        break;
+                    }
+
+                    this->emit(this->ctx, instr->opcode, this->makeRef(instr->slot), operand(val));
+                    release(val, i);
+                    break;
+                }
+
+                case IROp::ZERO:
+                    touch(instr->slot, instr->size);
+                    this->emitZeroFill(instr->slot, instr->size);
+                    break;
+
+                case IROp::BINOP: {
+                    IRInstr* L = instr->args[0];
+                    IRInstr* R = instr->args[1];
+                    size_t dst;
+
+                    // the result goes to the left operand, unless it is still needed or not in a register
+                    if(L != R && where.count(L) && last_use[L] == i) {
+                        dst = where[L];
+                        holder[dst] = nullptr;
+                        where.erase(L);
+                    } else {
+                        dst = alloc();
+                        if(dst == SIZE_MAX)
+                            goto bail;
+
+                        this->emit(this->ctx, Opcode::MOV, reg(dst), operand(L));
+                    }
+
+                    this->emit(this->ctx, instr->opcode, reg(dst), operand(R));
+                    release(L, i);
+                    release(R, i);
+                    hold(instr, dst);
+                    break;
+                }
+
+                case IROp::CALL: {
+                    // the callee returns through FNR and may use any other register
+                    if(holder[fnr]) {
+                        size_t idx = alloc();
+                        if(idx == SIZE_MAX)
+                            goto bail;
+
+                        this->emit(this->ctx, Opcode::MOV, reg(idx), reg(fnr));
+                        where[holder[fnr]] = idx;
+                        holder[idx] = holder[fnr];
+                        holder[fnr] = nullptr;
+                    }
+
+                    std::vector<size_t> saved;
+                    for(size_t idx = 0; idx < pool.size(); idx++) {
+                        if(holder[idx]) {
+                            saved.push_back(idx);
+                            this->emit(this->ctx, Opcode::PUSH, reg(idx), {OperandType::OP_NULL, 0});
+                        }
+                    }
+
+                    this->ctx.call_fixups.push_back({static_cast<uint32_t>(code.size()), instr->callee});
+                    this->emit(this->ctx, Opcode::CALL, this->makeIMM(0), {OperandType::OP_NULL, 0});
+
+                    for(size_t k = saved.size(); k-- > 0;)
+                        this->emit(this->ctx, Opcode::POP, reg(saved[k]), {OperandType::OP_NULL, 0});
+
+                    called = true;
+                    hold(instr, fnr);
+                    break;
+                }
+
+                case IROp::RET:
+                    this->emit(this->ctx, Opcode::RET, instr->args.empty() ? Operand{OperandType::OP_NULL, 0} : operand(instr->args[0]), {OperandType::OP_NULL, 0});
+                    break;
+
+                case IROp::HALT:
+                    this->emit(this->ctx, Opcode::HALT, {OperandType::OP_NULL, 0}, {OperandType::OP_NULL, 0});
+                    break;
+            }
+        }
+
+        for(const PendingInit& init: inits)
+            this->emitStaticInit(init.offset, init.size, init.val);
+
+        return true;
+
+    bail:
+        code.resize(code_mark);
+        this->ctx.call_fixups.resize(fixup_mark);
+        return false;
+    }
+
+    bool CompilerInstance::compileIR(ASTNode* node, IRPassManager& passes) {
+        IRFunction fn;
+        fn.node = node;
+        fn.name = node ? node->name() : "<global>";
+
+        this->buildIR(fn);
+        size_t changes = passes.run(fn);
+
+        TRACE_NL("IR " + fn.name + ", " + std::to_string(changes) + " pass runs changed it");
+        TRACE_NL(fn.dump());
+
+        if(node)
+            node->symbol->entry_ip = this->ctx.instructions.size();
+
+        if(!this->lowerIR(fn)) {
+            TRACE_NL("IR " + fn.name + " not lowered, compiling it directly");
+            return false;
+        }
+
+        for(const CompilerSyntaxException& warning: fn.warnings)
+            this->friendlyException(warning);
+
+        return true;
+    }
+};
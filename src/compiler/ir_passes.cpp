@@ -0,0 +1,261 @@
+#include "compiler/ir.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ULang {
+    // what a block knows about the contents of a slot
+    struct SlotFact {
+        uint32_t size;
+        IRInstr* stored;                ///< value last stored, nullptr if unknown
+        std::vector<IRInstr*> loads;    ///< loads of the current contents
+    };
+
+    struct BinopKey {
+        Opcode opcode;
+        const IRInstr* a;
+        const IRInstr* b;
+
+        bool operator==(const BinopKey& other) const {
+            return this->opcode == other.opcode && this->a == other.a && this->b == other.b;
+        }
+    };
+
+    struct BinopKeyHash {
+        size_t operator()(const BinopKey& key) const {
+            size_t h = std::hash<const void*>{}(key.a);
+            h = h * 31 + std::hash<const void*>{}(key.b);
+            return h * 31 + key.opcode;
+        }
+    };
+
+    template<typename T>
+    static void forgetOverlapping(std::unordered_map<uint32_t, T>& slots, uint32_t slot, uint32_t size, uint32_t (*sizeOf)(const T&)) {
+        // accesses are at most 8 bytes wide
+        for(uint32_t off = slot >= 7 ? slot - 7 : 0; off < slot + size; off++) {
+            auto it = slots.find(off);
+            if(it != slots.end() && off + sizeOf(it->second) > slot)
+                slots.erase(it);
+        }
+    }
+
+    static uint32_t factSize(const SlotFact& fact) {return fact.size;}
+    static uint32_t storeSize(IRInstr* const& store) {return store->size;}
+
+    static bool commutative(Opcode opcode) {
+        switch(opcode) {
+            case Opcode::ADD:   case Opcode::MUL:
+            case Opcode::ADD32: case Opcode::MUL32:
+            case Opcode::IADD32: case Opcode::IMUL32:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // x + 0, x * 1 and the like, only for 64-bit operations: the 32-bit ones also truncate x
+    static IRInstr* identity(Opcode opcode, IRInstr* a, IRInstr* b) {
+        auto is = [](const IRInstr* v, uint64_t val) {return v->op == IROp::CONST && v->imm == val;};
+
+        switch(opcode) {
+            case Opcode::ADD:   return is(b, 0) ? a : is(a, 0) ? b : nullptr;
+            case Opcode::MUL:   return is(b, 1) ? a : is(a, 1) ? b : nullptr;
+            case Opcode::SUB:   return is(b, 0) ? a : nullptr;
+            case Opcode::DIV:
+            case Opcode::IDIV:  return is(b, 1) ? a : nullptr;
+            default:            return nullptr;
+        }
+    }
+
+    bool IRValueNumbering::run(IRFunction& fn) {
+        bool changed = false;
+
+        for(IRBlock* block: fn.blocks) {
+            // nothing flows in from predecessors yet
+            std::unordered_map<uint32_t, SlotFact> memory;
+            std::unordered_map<BinopKey, IRInstr*, BinopKeyHash> exprs;
+
+            for(IRInstr* instr: block->instrs) {
+                if(instr->dead)
+                    continue;
+
+                switch(instr->op) {
+                    case IROp::LOAD: {
+                        auto it = memory.find(instr->slot);
+                        if(it == memory.end()) {
+                            memory.emplace(instr->slot, SlotFact{instr->size, nullptr, {instr}});
+                            break;
+                        }
+
+                        SlotFact& fact = it->second;
+                        if(fact.size != instr->size)
+                            break;
+
+                        // a stored value can stand in for the load only if the load would not change it:
+                        // constants are extended here, other values need the full width or an identical load
+                        IRInstr* known = nullptr;
+                        if(fact.stored) {
+                            if(fact.stored->op == IROp::CONST)
+                                known = fn.constant(evalLoad(instr->opcode, fact.stored->imm));
+                            else if(instr->size == 8 || (fact.stored->op == IROp::LOAD && fact.stored->opcode == instr->opcode))
+                                known = fact.stored;
+                        }
+
+                        for(IRInstr* load: fact.loads) {
+                            if(!known && load->opcode == instr->opcode)
+                                known = load;
+                        }
+
+                        if(!known) {
+                            fact.loads.push_back(instr);
+                            break;
+                        }
+
+                        fn.replaceAllUses(instr, known);
+                        fn.erase(instr);
+                        changed = true;
+                        break;
+                    }
+
+                    case IROp::STORE:
+                        forgetOverlapping(memory, instr->slot, instr->size, factSize);
+                        memory.emplace(instr->slot, SlotFact{instr->size, instr->args[0], {}});
+                        break;
+
+                    case IROp::ZERO:
+                        forgetOverlapping(memory, instr->slot, instr->size, factSize);
+                        if(instr->size <= 8)
+                            memory.emplace(instr->slot, SlotFact{instr->size, fn.constant(0), {}});
+                        break;
+
+                    case IROp::CALL:
+                        memory.clear();
+                        break;
+
+                    case IROp::BINOP: {
+                        IRInstr* a = instr->args[0];
+                        IRInstr* b = instr->args[1];
+
+                        uint64_t val;
+                        if(a->op == IROp::CONST && b->op == IROp::CONST && evalBinop(instr->opcode, a->imm, b->imm, val)) {
+                            fn.replaceAllUses(instr, fn.constant(val));
+                            fn.erase(instr);
+                            changed = true;
+                            break;
+                        }
+
+                        IRInstr* same = identity(instr->opcode, a, b);
+                        if(same) {
+                            fn.replaceAllUses(instr, same);
+                            fn.erase(instr);
+                            changed = true;
+                            break;
+                        }
+
+                        if(commutative(instr->opcode) && a->id > b->id)
+                            std::swap(a, b);
+
+                        auto [it, inserted] = exprs.emplace(BinopKey{instr->opcode, a, b}, instr);
+                        if(inserted)
+                            break;
+
+                        fn.replaceAllUses(instr, it->second);
+                        fn.erase(instr);
+                        changed = true;
+                        break;
+                    }
+
+                    default:
+                        break;
+                }
+            }
+        }
+
+        return changed;
+    }
+
+    static void dropBlock(IRBlock* block) {
+        for(IRInstr* instr: block->instrs) {
+            for(IRInstr* arg: instr->args)
+                arg->dropUser(instr);
+
+            instr->args.clear();
+        }
+
+        for(IRInstr* instr: block->instrs) {
+            instr->users.clear();
+            instr->dead = true;
+        }
+
+        block->instrs.clear();
+    }
+
+    bool IRDeadCode::run(IRFunction& fn) {
+        bool changed = false;
+
+        // everything but the entry needs a predecessor
+        for(size_t i = 1; i < fn.blocks.size(); i++) {
+            if(!fn.blocks[i]->preds.empty())
+                continue;
+
+            for(IRBlock* succ: fn.blocks[i]->succs)
+                succ->preds.erase(std::find(succ->preds.begin(), succ->preds.end(), fn.blocks[i]));
+
+            dropBlock(fn.blocks[i]);
+            fn.blocks.erase(fn.blocks.begin() + i--);
+            changed = true;
+        }
+
+        for(IRBlock* block: fn.blocks) {
+            // backwards, so that the operands of a removed value are seen unused afterwards
+            for(size_t i = block->instrs.size(); i-- > 0;) {
+                IRInstr* instr = block->instrs[i];
+                if(instr->dead || !instr->users.empty() || !instr->isPure())
+                    continue;
+
+                fn.erase(instr);
+                changed = true;
+            }
+
+            // stores nothing reads before the next store to the same slot
+            std::unordered_map<uint32_t, IRInstr*> pending;
+
+            for(IRInstr* instr: block->instrs) {
+                if(instr->dead)
+                    continue;
+
+                switch(instr->op) {
+                    case IROp::LOAD:
+                    case IROp::ZERO:
+                        forgetOverlapping(pending, instr->slot, instr->size, storeSize);
+                        break;
+
+                    case IROp::STORE: {
+                        auto it = pending.find(instr->slot);
+                        if(it != pending.end() && it->second->size == instr->size) {
+                            fn.erase(it->second);
+                            changed = true;
+                        }
+
+                        forgetOverlapping(pending, instr->slot, instr->size, storeSize);
+                        pending[instr->slot] = instr;
+                        break;
+                    }
+
+                    // the callee, the caller or whoever looks at the heap afterwards may read anything
+                    case IROp::CALL:
+                    case IROp::RET:
+                    case IROp::HALT:
+                        pending.clear();
+                        break;
+
+                    default:
+                        break;
+                }
+            }
+        }
+
+        return changed;
+    }
+};
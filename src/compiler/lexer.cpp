@@ -1,5 +1,6 @@
 #include "compiler.hpp"
 #include "compiler/errno.h"
+#include "keywords.hpp"
 #include "types.hpp"
 
 #include <cctype>
@@ -10,8 +11,8 @@
 #include <string>
 
 namespace ULang {
-    Lexer::Lexer(const std::string& input)
-    : src(input), pos(0) {}
+    Lexer::Lexer(std::string_view input)
+    : src(input), pos(0), scan(&scanKernels()) {}
 
     char Lexer::peek() const {
         return this->pos < this->src.size() ? this->src[this->pos] : '\0';
@@ -30,130 +31,151 @@ namespace ULang {
         return c;
     }
 
-    std::vector<Token> Lexer::tokenize(const std::string& filename) {
-        std::vector<Token> tokens;
-        
+    void Lexer::skipRun(size_t len) {
+        this->pos += len;
+        this->col += len;
+    }
+
+    void Lexer::reset(uint32_t file) {
         this->pos = 0;
         this->line = 1;
         this->col = 1;
+        this->file = file;
+    }
 
-        while(this->pos < this->src.size()) {
-            char c = this->peek();
-
-            // whitespaces
-            if(std::isspace(c)) {
-                THROW_AWAY this->get();
-                continue;
-            }
+    Token Lexer::next() {
+        // whitespaces
+        while(this->pos < this->src.size() && std::isspace(this->peek())) {
+            size_t lines, tail;
+            size_t len = this->scan->whitespace(this->src.data() + this->pos, this->src.size() - this->pos, lines, tail);
+
+            this->pos += len;
+            if(lines) {
+                this->line += lines;
+                this->col = tail + 1;
+            } else this->col += len;
+        }
 
-            // numbers
-            if(std::isdigit(c)) {
-                std::string numstr;
-                size_t tok_col = this->col;
+        // EOF, returned again on every further call
+        if(this->pos >= this->src.size())
+            return {TokenType::EndOfFile, std::string_view(), {nullptr, this->file, this->line, this->col}};
 
-                while(std::isdigit(this->peek()) || (numstr.size() > 0 && this->peek() == '_'))
-                    numstr += this->get();
+        char c = this->peek();
+        size_t tok_start = this->pos;
+        size_t tok_col = this->col;
 
-                tokens.push_back({TokenType::Number, numstr, {
-                    nullptr,
-                    filename,
-                    this->line,
-                    tok_col
-                }});
+        // numbers
+        if(std::isdigit(c)) {
+            this->skipRun(1 + this->scan->digits(this->src.data() + this->pos + 1, this->src.size() - this->pos - 1));
+            return {TokenType::Number, this->src.substr(tok_start, this->pos - tok_start), {nullptr, this->file, this->line, tok_col}};
+        }
 
-                continue;
+        // character literal, the text keeps the quotes so the parser can tell it from a number
+        if(c == '\'') {
+            this->get();
+            this->get();
+
+            if(this->peek() != '\'') {
+                throw CompilerSyntaxException(
+                    CompilerSyntaxException::Severity::Error,
+                    "Expected closing quote for character literal",
+                    {nullptr, this->file, this->line, tok_col},
+                    ULANG_SYNT_ERR_MISSING_CLOSE_QUOTE
+                );
             }
 
-            // character literal
-            if(c == '\'') {
-                size_t tok_col = this->col;
-                this->get();
-                char ch = this->get();
-
-                if(this->peek() != '\'') {
-                    throw CompilerSyntaxException(
-                        CompilerSyntaxException::Severity::Error,
-                        "Expected closing quote for character literal",
-                        {nullptr, filename, this->line, tok_col},
-                        ULANG_SYNT_ERR_MISSING_CLOSE_QUOTE
-                    );
-                }
+            this->get();
+            return {TokenType::Number, this->src.substr(tok_start, this->pos - tok_start), {nullptr, this->file, this->line, tok_col}};
+        }
 
-                this->get();
+        // identifiers, keywords
+        if(std::isalpha(c)) {
+            this->skipRun(1 + this->scan->identifier(this->src.data() + this->pos + 1, this->src.size() - this->pos - 1));
 
-                std::string sval = std::to_string(static_cast<uint32_t>(ch));
-                tokens.push_back({TokenType::Number, sval, {
-                    nullptr,
-                    filename,
-                    this->line,
-                    tok_col
-                }});
+            std::string_view str = this->src.substr(tok_start, this->pos - tok_start);
+            TokenType tt = TokenType::Identifier;
 
-                continue;
+            if(const KeywordEntry* kw = lookupKeyword(str)) {
+                switch(kw->keyword) {
+                    case Keyword::FUNCTION: tt = TokenType::Function;       break;
+                    case Keyword::RETURN:   tt = TokenType::Return;         break;
+                    case Keyword::TYPE:     tt = TokenType::TypeKeyword;    break;
+                    case Keyword::NONE:                                     break;
+                }
             }
 
-            // identifiers, keywords
-            if(std::isalpha(c)) {
-                std::string str;
-                size_t tok_col = this->col;
+            return {tt, str, {nullptr, this->file, this->line, tok_col}};
+        }
 
-                while(std::isalnum(this->peek()) || this->peek() == '_') {
-                    str += this->get();
-                }
+        TokenType tt;
+
+        // operators
+        switch(c) {
+            case '+': tt = TokenType::Plus;      break;
+            case '-': tt = TokenType::Minus;     break;
+            case '*': tt = TokenType::Mul;       break;
+            case '/': tt = TokenType::Div;       break;
+            case '=': tt = TokenType::Assign;    break;
+
+            case ';': tt = TokenType::Semicolon; break;
+            case ',': tt = TokenType::Comma;     break;
+
+            case '(': tt = TokenType::LParen;    break;
+            case ')': tt = TokenType::RParen;    break;
+            case '{': tt = TokenType::LCurly;    break;
+            case '}': tt = TokenType::RCurly;    break;
+            
+            default: 
+                throw std::runtime_error(std::string("Unknown character: ") + c);
+        }
 
-                TokenType tt = TokenType::Identifier;
-
-                if(str == "fn")             tt = TokenType::Function;
-                else if(str == "return")    tt = TokenType::Return;
-                else try {
-                    const DataType* type = resolveDataType(str);
-                    tt = TokenType::TypeKeyword;
-                    str = type->name;
-                } catch(const std::exception& e) {
-                    THROW_AWAY e;
-                };
-
-                tokens.push_back({tt, str, {
-                        nullptr,
-                        filename,
-                        this->line,
-                        tok_col
-                    }});
-
-                continue;
-            }
+        THROW_AWAY this->get();
+        return {tt, this->src.substr(tok_start, 1), {nullptr, this->file, this->line, tok_col}};
+    }
 
-            size_t tok_col = this->col;
-
-            // operators
-            switch(c) {
-                case '+': tokens.push_back({TokenType::Plus,     std::string(1, this->get()), {nullptr, filename, this->line, tok_col}}); break;
-                case '-': tokens.push_back({TokenType::Minus,    std::string(1, this->get()), {nullptr, filename, this->line, tok_col}}); break;
-                case '*': tokens.push_back({TokenType::Mul,      std::string(1, this->get()), {nullptr, filename, this->line, tok_col}}); break;
-                case '/': tokens.push_back({TokenType::Div,      std::string(1, this->get()), {nullptr, filename, this->line, tok_col}}); break;
-                case '=': tokens.push_back({TokenType::Assign,   std::string(1, this->get()), {nullptr, filename, this->line, tok_col}}); break;
-
-                case ';': tokens.push_back({TokenType::Semicolon,std::string(1, this->get()), {nullptr, filename, this->line, tok_col}}); break;
-                case ',': tokens.push_back({TokenType::Comma,std::string(1, this->get()), {nullptr, filename, this->line, tok_col}}); break;
-
-                case '(': tokens.push_back({TokenType::LParen,std::string(1, this->get()), {nullptr, filename, this->line, tok_col}}); break;
-                case ')': tokens.push_back({TokenType::RParen,std::string(1, this->get()), {nullptr, filename, this->line, tok_col}}); break;
-                case '{': tokens.push_back({TokenType::LCurly,std::string(1, this->get()), {nullptr, filename, this->line, tok_col}}); break;
-                case '}': tokens.push_back({TokenType::RCurly,std::string(1, this->get()), {nullptr, filename, this->line, tok_col}}); break;
-                
-                default: 
-                    throw std::runtime_error(std::string("Unknown character: ") + c);
-            }
-        }
+    std::vector<Token> Lexer::tokenize(uint32_t file) {
+        std::vector<Token> tokens;
+        this->reset(file);
 
-        // EOF
-        tokens.push_back({TokenType::EndOfFile, "", {
-            nullptr,
-            filename,
-            this->line,
-            this->col
-        }});
+        do {
+            tokens.push_back(this->next());
+        } while(tokens.back().type != TokenType::EndOfFile);
         
         return tokens;
     }
+
+    void TokenStream::start(uint32_t file) {
+        this->lexer.reset(file);
+        this->head = 0;
+        this->filled = 0;
+        this->consumed = 0;
+    }
+
+    const Token& TokenStream::peek(size_t ahead) {
+        if(ahead >= ULANG_TOKEN_LOOKAHEAD)
+            throw std::runtime_error("token lookahead out of range");
+
+        while(this->filled <= ahead) {
+            this->window[(this->head + this->filled) % ULANG_TOKEN_LOOKAHEAD] = this->lexer.next();
+            this->filled++;
+        }
+
+        return this->window[(this->head + ahead) % ULANG_TOKEN_LOOKAHEAD];
+    }
+
+    Token TokenStream::next() {
+        Token tok = this->peek();
+        this->advance();
+        return tok;
+    }
+
+    void TokenStream::advance(size_t n) {
+        for(; n > 0; n--) {
+            THROW_AWAY this->peek();
+
+            this->head = (this->head + 1) % ULANG_TOKEN_LOOKAHEAD;
+            this->filled--;
+            this->consumed++;
+        }
+    }
 };
\ No newline at end of file
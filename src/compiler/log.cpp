@@ -6,13 +6,16 @@
 #include <string>
 
 namespace ULang {
-    void CompilerInstance::verbose_nl(std::string str, bool ignore_depth) {
+    void CompilerInstance::verbose_nl(const std::string& str, bool ignore_depth) {
+        // the indentation grows with the nesting depth, skip it altogether
+        if(!this->cparams.verbose) return;
+
         this->verbose_print("\n");
         if(this->verbose_depthLvl > 0) {
             if(ignore_depth) {
                 this->verbose_print("\t");
             } else {
-                for(int i = 0; i < this->verbose_depthLvl; i++)
+                for(unsigned int i = 0; i < this->verbose_depthLvl; i++)
                     this->verbose_print("  ");
                 this->verbose_print(" --> ");
             }
@@ -21,7 +24,7 @@ namespace ULang {
         this->verbose_print(str);
     }
 
-    void CompilerInstance::verbose_print(std::string str) {
+    void CompilerInstance::verbose_print(const std::string& str) {
         if(!this->cparams.verbose) return;
         std::cout << str;
     }
@@ -1,15 +1,64 @@
 #include "compiler.hpp"
 #include <boost/program_options.hpp>
 #include <boost/program_options/value_semantic.hpp>
+#include <chrono>
 #include <cstdint>
-#include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
 
 #include "params.hpp"
 
 namespace po = boost::program_options;
 
+#define LEX_BENCH_RUNS 5
+
+/**
+ * @brief Tokenizes the source with every scanner implementation and reports the best of LEX_BENCH_RUNS runs
+ */
+static int lexBenchmark(std::string_view source, const ULang::CompilerParameters& cparams) {
+    uint32_t file = ULang::internSourceFile(cparams.sourceFile);
+
+    std::vector<const ULang::ScanKernels*> impls = {&ULang::scanKernelsScalar()};
+    if(&ULang::scanKernels() != impls[0])
+        impls.push_back(&ULang::scanKernels());
+
+    for(const ULang::ScanKernels* impl: impls) {
+        ULang::Lexer lexer(source);
+        lexer.setScanKernels(*impl);
+
+        double best = 0;
+        size_t count = 0;
+
+        for(int run = 0; run < LEX_BENCH_RUNS; run++) {
+            auto start = std::chrono::steady_clock::now();
+
+            try {
+                lexer.reset(file);
+                count = 1;
+
+                while(lexer.next().type != ULang::TokenType::EndOfFile)
+                    count++;
+            } catch(const ULang::CompilerSyntaxException& e) {
+                std::cerr << e.fmt(true) << std::endl;
+                return 1;
+            } catch(const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+
+            double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if(run == 0 || secs < best)
+                best = secs;
+        }
+
+        std::cout << "LEX: " << impl->isa << ": " << count << " tokens in " << best * 1000 << " ms, "
+                  << (source.size() / (1024.0 * 1024.0)) / best << " MiB/s" << std::endl;
+    }
+
+    return 0;
+}
+
 int main(int argc, char** argv) {
     ULang::CompilerParameters cparams;
 
@@ -20,7 +69,12 @@ int main(int argc, char** argv) {
         ("file,f", po::value<std::string>(&cparams.sourceFile), "Source file")
         ("output,o", po::value<std::string>(&cparams.outFile)->default_value("a.out"), "Output file")
         ("verbose", po::bool_switch(&cparams.verbose)->default_value(false), "Generate verbose compilation log")
-        ("exclude-builtin", po::bool_switch(&cparams.excludeBuiltin)->default_value(false), "Exclude builtin symbols from the compilation");
+        ("exclude-builtin", po::bool_switch(&cparams.excludeBuiltin)->default_value(false), "Exclude builtin symbols from the compilation")
+        ("compact", po::bool_switch(&cparams.compact)->default_value(false), "Emit variable-length compact bytecode")
+        ("compress", po::bool_switch(&cparams.compress)->default_value(false), "Compress the code and data sections")
+        ("lex-only", po::bool_switch(&cparams.lexOnly)->default_value(false), "Only tokenize the source and report the lexing throughput")
+        ("explicit-zero", po::bool_switch(&cparams.OExplicitZero)->default_value(false), "Explicitly zero variables declared without an initial value")
+        ("optimize,O", po::bool_switch(&cparams.optimize)->default_value(false), "Optimize the code in SSA form before emitting it");
 
     po::variables_map vm;
     try {
@@ -36,21 +90,25 @@ int main(int argc, char** argv) {
         return 0;
     }
 
-    std::ifstream file(cparams.sourceFile);
-    if(!file.is_open()) {
-        std::cerr << "Cannot open file: " << cparams.sourceFile << "\n";
+    std::unique_ptr<ULang::SourceBuffer> source;
+    try {
+        source = std::make_unique<ULang::SourceBuffer>(cparams.sourceFile);
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << "\n";
         return 1;
     }
 
-    std::string sourceCode((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-    std::cout << "Loaded " << sourceCode.size() << " bytes from" << cparams.sourceFile << ", output: " << cparams.outFile << "\n";
+    std::string_view sourceCode = source->view();
+    if(ULANG_TRACE_ENABLED && cparams.verbose)
+        std::cout << "Loaded " << sourceCode.size() << " bytes from " << cparams.sourceFile << ", output: " << cparams.outFile << "\n";
 
-    ULang::Lexer lexer(sourceCode);
-    THROW_AWAY lexer.tokenize();
+    if(cparams.lexOnly)
+        return lexBenchmark(sourceCode, cparams);
 
     ULang::CompilerInstance* ci = new ULang::CompilerInstance(sourceCode, cparams);
     THROW_AWAY ci->compile();
-    std::cout << "Compile OK" << std::endl;
+    if(ULANG_TRACE_ENABLED && cparams.verbose)
+        std::cout << "Compile OK" << std::endl;
 
     delete ci;
     return 0;
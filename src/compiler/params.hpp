@@ -9,9 +9,13 @@ namespace ULang {
         std::string outFile;
 
         bool excludeBuiltin;
+        bool compact;       ///< Whether to emit the variable-length instruction encoding (BC_FLAG_COMPACT)
+        bool compress;      ///< Whether to LZ-compress the code and data sections (BC_FLAG_COMPRESSED)
+        bool lexOnly;       ///< Whether to only tokenize the source and report the lexing throughput
 
         // --- optimalization ---
         bool OExplicitZero; ///< Whether declaration without assignment should explicitely assign zero
+        bool optimize;      ///< Whether to compile through the IR and its passes (BC_FLAG_OPTIMIZED)
     };
 };
 
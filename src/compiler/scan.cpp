@@ -0,0 +1,187 @@
+#include "scan.hpp"
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define ULANG_SCAN_X86
+#endif
+
+using namespace ULang;
+
+// ==================================================================
+// ======== SCALAR (portable fallback, also finishes the vector tails)
+// ==================================================================
+
+static inline bool isWs(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static inline bool isIdent(char c) {
+    char lower = c | 0x20;
+    return (lower >= 'a' && lower <= 'z') || isDigit(c) || c == '_';
+}
+
+static size_t scalarWhitespace(const char* p, size_t n, size_t& lines, size_t& tail) {
+    size_t i = 0;
+    size_t last_nl = SIZE_MAX;
+    lines = 0;
+
+    for(; i < n && isWs(p[i]); i++) {
+        if(p[i] == '\n') {
+            lines++;
+            last_nl = i;
+        }
+    }
+
+    tail = lines ? i - last_nl - 1 : i;
+    return i;
+}
+
+static size_t scalarIdentifier(const char* p, size_t n) {
+    size_t i = 0;
+    while(i < n && isIdent(p[i]))
+        i++;
+
+    return i;
+}
+
+static size_t scalarDigits(const char* p, size_t n) {
+    size_t i = 0;
+    while(i < n && (isDigit(p[i]) || p[i] == '_'))
+        i++;
+
+    return i;
+}
+
+// ==================================================================
+// ======== VECTOR (one block of W bytes per step)
+// ==================================================================
+
+#if defined(ULANG_SCAN_X86) && defined(__GNUC__)
+
+#define ULANG_SCAN_VECTOR
+
+/*
+    Bytes >= 0x80 compare as negative, so they never fall into any of the ASCII ranges.
+    IN_RANGE uses cmpgt both ways since there is no 256-bit cmplt.
+*/
+#define SCAN_KERNELS(PFX, TARGET, W, VEC, LOAD, SET1, CMPEQ, CMPGT, AND, OR, MOVEMASK)                  \
+    TARGET static inline VEC PFX##_inRange(VEC c, char lo, char hi) {                                   \
+        return AND(CMPGT(c, SET1(lo - 1)), CMPGT(SET1(hi + 1), c));                                     \
+    }                                                                                                   \
+                                                                                                        \
+    TARGET static size_t PFX##_whitespace(const char* p, size_t n, size_t& lines, size_t& tail) {       \
+        size_t i = 0;                                                                                   \
+        size_t nl_count = 0;                                                                            \
+        size_t last_nl = SIZE_MAX;                                                                      \
+                                                                                                        \
+        for(; i + W <= n; i += W) {                                                                     \
+            VEC c = LOAD(reinterpret_cast<const VEC*>(p + i));                                          \
+            uint32_t ws = MOVEMASK(OR(CMPEQ(c, SET1(' ')), PFX##_inRange(c, '\t', '\r')));              \
+            uint32_t nl = MOVEMASK(CMPEQ(c, SET1('\n')));                                               \
+                                                                                                        \
+            uint32_t stop = ~ws & (W == 32 ? 0xFFFFFFFFu : 0xFFFFu);                                    \
+            size_t run = stop ? __builtin_ctz(stop) : W;                                                \
+            if(run < W)                                                                                 \
+                nl &= (1u << run) - 1;                                                                  \
+                                                                                                        \
+            if(nl) {                                                                                    \
+                nl_count += __builtin_popcount(nl);                                                     \
+                last_nl = i + 31 - __builtin_clz(nl);                                                   \
+            }                                                                                           \
+                                                                                                        \
+            if(stop) {                                                                                  \
+                i += run;                                                                               \
+                lines = nl_count;                                                                       \
+                tail = nl_count ? i - last_nl - 1 : i;                                                  \
+                return i;                                                                               \
+            }                                                                                           \
+        }                                                                                               \
+                                                                                                        \
+        size_t rest_lines, rest_tail;                                                                   \
+        size_t rest = scalarWhitespace(p + i, n - i, rest_lines, rest_tail);                            \
+                                                                                                        \
+        if(rest_lines)                                                                                  \
+            last_nl = i + rest - rest_tail - 1;                                                         \
+        i += rest;                                                                                      \
+        nl_count += rest_lines;                                                                         \
+                                                                                                        \
+        lines = nl_count;                                                                               \
+        tail = nl_count ? i - last_nl - 1 : i;                                                          \
+        return i;                                                                                       \
+    }                                                                                                   \
+                                                                                                        \
+    TARGET static size_t PFX##_identifier(const char* p, size_t n) {                                    \
+        size_t i = 0;                                                                                   \
+        for(; i + W <= n; i += W) {                                                                     \
+            VEC c = LOAD(reinterpret_cast<const VEC*>(p + i));                                          \
+            VEC alpha = PFX##_inRange(OR(c, SET1(0x20)), 'a', 'z');                                     \
+            VEC cls = OR(OR(alpha, PFX##_inRange(c, '0', '9')), CMPEQ(c, SET1('_')));                   \
+                                                                                                        \
+            uint32_t stop = ~static_cast<uint32_t>(MOVEMASK(cls)) & (W == 32 ? 0xFFFFFFFFu : 0xFFFFu);  \
+            if(stop)                                                                                    \
+                return i + __builtin_ctz(stop);                                                         \
+        }                                                                                               \
+                                                                                                        \
+        return i + scalarIdentifier(p + i, n - i);                                                      \
+    }                                                                                                   \
+                                                                                                        \
+    TARGET static size_t PFX##_digits(const char* p, size_t n) {                                        \
+        size_t i = 0;                                                                                   \
+        for(; i + W <= n; i += W) {                                                                     \
+            VEC c = LOAD(reinterpret_cast<const VEC*>(p + i));                                          \
+            VEC cls = OR(PFX##_inRange(c, '0', '9'), CMPEQ(c, SET1('_')));                              \
+                                                                                                        \
+            uint32_t stop = ~static_cast<uint32_t>(MOVEMASK(cls)) & (W == 32 ? 0xFFFFFFFFu : 0xFFFFu);  \
+            if(stop)                                                                                    \
+                return i + __builtin_ctz(stop);                                                         \
+        }                                                                                               \
+                                                                                                        \
+        return i + scalarDigits(p + i, n - i);                                                          \
+    }
+
+#define SCAN_TARGET_SSE2 __attribute__((target("sse2")))
+#define SCAN_TARGET_AVX2 __attribute__((target("avx2")))
+
+SCAN_KERNELS(sse2, SCAN_TARGET_SSE2, 16, __m128i, _mm_loadu_si128, _mm_set1_epi8,
+             _mm_cmpeq_epi8, _mm_cmpgt_epi8, _mm_and_si128, _mm_or_si128, _mm_movemask_epi8)
+
+SCAN_KERNELS(avx2, SCAN_TARGET_AVX2, 32, __m256i, _mm256_loadu_si256, _mm256_set1_epi8,
+             _mm256_cmpeq_epi8, _mm256_cmpgt_epi8, _mm256_and_si256, _mm256_or_si256, _mm256_movemask_epi8)
+
+#endif
+
+// ==================================================================
+// ======== DISPATCH
+// ==================================================================
+
+static const ScanKernels scalar_kernels = {scalarWhitespace, scalarIdentifier, scalarDigits, "scalar"};
+
+static ScanKernels selectKernels() {
+#ifdef ULANG_SCAN_VECTOR
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("avx2"))
+        return {avx2_whitespace, avx2_identifier, avx2_digits, "avx2"};
+
+    if(__builtin_cpu_supports("sse2"))
+        return {sse2_whitespace, sse2_identifier, sse2_digits, "sse2"};
+#endif
+
+    return scalar_kernels;
+}
+
+namespace ULang {
+    const ScanKernels& scanKernels() {
+        static const ScanKernels selected = selectKernels();
+        return selected;
+    }
+
+    const ScanKernels& scanKernelsScalar() {
+        return scalar_kernels;
+    }
+};
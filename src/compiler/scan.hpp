@@ -0,0 +1,38 @@
+#ifndef __ULANG_SCAN_H
+#define __ULANG_SCAN_H
+
+#include <cstddef>
+
+namespace ULang {
+    /**
+     * @brief Character-class scanners used by the lexer, classifying a block of bytes per step
+     *
+     * Every scanner returns the length of the run of matching bytes at the start of p, looking at most n bytes.
+     * Classes are ASCII only, as with std::isspace/std::isalnum in the "C" locale.
+     */
+    struct ScanKernels {
+        /**
+         * @brief Whitespace (' ', '\\t', '\\n', '\\v', '\\f', '\\r') run
+         * @param lines receives the number of '\\n' in the run
+         * @param tail receives the number of bytes after the last '\\n' of the run, the whole run if there is none
+         */
+        size_t (*whitespace)(const char* p, size_t n, size_t& lines, size_t& tail);
+
+        size_t (*identifier)(const char* p, size_t n);  ///< [A-Za-z0-9_] run
+        size_t (*digits)(const char* p, size_t n);      ///< [0-9_] run
+
+        const char* isa;
+    };
+
+    /**
+     * @brief Returns the fastest scanners the CPU supports (avx2, sse2 or scalar)
+     */
+    const ScanKernels& scanKernels();
+
+    /**
+     * @brief Returns the portable byte-at-a-time scanners
+     */
+    const ScanKernels& scanKernelsScalar();
+};
+
+#endif
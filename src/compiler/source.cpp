@@ -0,0 +1,78 @@
+#include "source.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace ULang {
+    SourceBuffer::SourceBuffer(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+            throw std::runtime_error("Cannot open file: " + path + ": " + std::strerror(errno));
+
+        struct stat st;
+        if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if(map != MAP_FAILED) {
+                madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+                this->data = static_cast<const char*>(map);
+                this->size = st.st_size;
+                this->mapped = true;
+
+                close(fd);
+                return;
+            }
+        }
+
+        char chunk[64 * 1024];
+        ssize_t n;
+        while((n = read(fd, chunk, sizeof(chunk))) != 0) {
+            if(n < 0) {
+                if(errno == EINTR)
+                    continue;
+
+                int err = errno;
+                close(fd);
+                throw std::runtime_error("Cannot read file: " + path + ": " + std::strerror(err));
+            }
+
+            this->owned.append(chunk, n);
+        }
+
+        close(fd);
+        this->data = this->owned.data();
+        this->size = this->owned.size();
+    }
+
+    SourceBuffer::~SourceBuffer() {
+        if(this->mapped)
+            munmap(const_cast<char*>(this->data), this->size);
+    }
+
+    static std::vector<std::string> file_names = {"(unknown)"};
+    static std::unordered_map<std::string, uint32_t> file_ids = {{"(unknown)", ULANG_FILE_UNKNOWN}};
+
+    uint32_t internSourceFile(const std::string& name) {
+        auto it = file_ids.find(name);
+        if(it != file_ids.end())
+            return it->second;
+
+        uint32_t id = static_cast<uint32_t>(file_names.size());
+        file_names.push_back(name);
+        file_ids.emplace(name, id);
+
+        return id;
+    }
+
+    const std::string& sourceFileName(uint32_t id) {
+        return id < file_names.size() ? file_names[id] : file_names[ULANG_FILE_UNKNOWN];
+    }
+};
@@ -0,0 +1,51 @@
+#ifndef __ULANG_SOURCE_H
+#define __ULANG_SOURCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#define ULANG_FILE_UNKNOWN 0    ///< file id of "(unknown)"
+
+namespace ULang {
+    /**
+     * @brief Read-only view of a source file
+     *
+     * Regular files are mapped into memory, anything else (pipes, character devices) is read
+     * into an owned buffer. Tokens slice the view directly, so it has to outlive the compilation.
+     */
+    class SourceBuffer {
+        private:
+        const char* data = nullptr;
+        size_t size = 0;
+        bool mapped = false;
+        std::string owned;      ///< contents when the file could not be mapped
+
+        public:
+        /**
+         * @brief Maps the file
+         * @exception std::runtime_error if the file cannot be opened or read
+         */
+        SourceBuffer(const std::string& path);
+        ~SourceBuffer();
+
+        SourceBuffer(const SourceBuffer&) = delete;
+        SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+        std::string_view view() const {return std::string_view(this->data, this->size);};
+    };
+
+    /**
+     * @brief Interns a file name
+     * @return uint32_t file id, the same for equal names
+     */
+    uint32_t internSourceFile(const std::string& name);
+
+    /**
+     * @brief Returns the name of an interned file, "(unknown)" for ids never handed out
+     */
+    const std::string& sourceFileName(uint32_t id);
+};
+
+#endif
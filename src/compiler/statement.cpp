@@ -2,22 +2,22 @@
 
 namespace ULang {
     ASTNode* CompilerInstance::parseStatement() {
-        Token& tok = this->tokens[this->pos];
+        Token tok = this->tokens.peek();
 
         if(tok.type == TokenType::Return) {
-            this->pos++;
+            this->tokens.advance();
             ASTNode* ret_expr = nullptr;
 
-            if(this->tokens[this->pos].type != TokenType::Semicolon && this->tokens[this->pos].type != TokenType::RCurly)
+            if(this->tokens.peek().type != TokenType::Semicolon && this->tokens.peek().type != TokenType::RCurly)
                 ret_expr = this->parseExpression();
 
             // matchToken(TokenType::Semicolon);
             // this->expectToken(TokenType::Semicolon);
 
-            if(this->tokens[this->pos].type == TokenType::Semicolon)
-                this->pos++;
+            if(this->tokens.peek().type == TokenType::Semicolon)
+                this->tokens.advance();
 
-            ASTNode* node = new ASTNode(ASTNodeType::FN_RET);
+            ASTNode* node = this->ast.make(ASTNodeType::FN_RET);
             node->initial = ret_expr;
             return node;
         }
@@ -26,27 +26,26 @@ namespace ULang {
             return this->parseVarDecl();
 
         // assignment out of declaration
-        if(tok.type == TokenType::Identifier && this->tokens[this->pos + 1].type == TokenType::Assign) {
+        if(tok.type == TokenType::Identifier && this->tokens.peek(1).type == TokenType::Assign) {
             const Symbol* sym = this->symbols.lookup(tok.text);
             if(!sym) {
                 throw CompilerSyntaxException(
                     CompilerSyntaxException::Severity::Error,
-                    "'" + tok.text + "' is not declared in this scope",
+                    "'" + std::string(tok.text) + "' is not declared in this scope",
                     tok.loc,
                     ULANG_SYNT_ERR_VAR_UNDEFINED
                 );
             }
 
-            ASTNode* node = new ASTNode(ASTNodeType::ASSIGNMENT);
-            ASTNode* lhs = new ASTNode(ASTNodeType::VARIABLE);
-            lhs->name = tok.text;
+            ASTNode* node = this->ast.make(ASTNodeType::ASSIGNMENT);
+            ASTNode* lhs = this->ast.make(ASTNodeType::VARIABLE);
             lhs->symbol = const_cast<Symbol *>(sym);
             node->lefthand = lhs;
 
-            this->verbose_nl("Assignment LHS: " + tok.text + ", following: " + this->tokens[this->pos + 1].text);
+            TRACE_NL("Assignment LHS: " + std::string(tok.text) + ", following: " + std::string(this->tokens.peek(1).text));
             this->verbose_ascend();
             
-            this->pos += 2;
+            this->tokens.advance(2);
 
             node->righthand = parseExpression();
             if(!node->righthand) {
@@ -1,84 +1,194 @@
 #include "compiler.hpp"
+#include <functional>
 #include <iostream>
 #include <stdexcept>
 #include <string>
 
+#define NAME_TABLE_MIN_SLOTS    64
+#define BINDING_MIN_SLOTS       64
+
 namespace ULang {
-    SymbolTable::SymbolTable(): nextSymbolId(16) {
-        this->scope_global = new Scope;
-        this->scope_global->_name = "<global>";
-        this->scope_global->parent = nullptr;
+    void NameTable::grow() {
+        std::vector<Slot> old = std::move(this->slots);
+        this->slots.assign(old.empty() ? NAME_TABLE_MIN_SLOTS : old.size() * 2, {0, ULANG_ATOM_NONE});
+
+        size_t mask = this->slots.size() - 1;
+        for(const Slot& slot: old) {
+            if(slot.atom == ULANG_ATOM_NONE)
+                continue;
+
+            size_t i = slot.hash & mask;
+            while(this->slots[i].atom != ULANG_ATOM_NONE)
+                i = (i + 1) & mask;
+
+            this->slots[i] = slot;
+        }
+    }
+
+    uint32_t NameTable::find(std::string_view name) const {
+        if(this->slots.empty())
+            return ULANG_ATOM_NONE;
+
+        uint32_t hash = static_cast<uint32_t>(std::hash<std::string_view>{}(name));
+        size_t mask = this->slots.size() - 1;
+
+        for(size_t i = hash & mask; this->slots[i].atom != ULANG_ATOM_NONE; i = (i + 1) & mask) {
+            const Slot& slot = this->slots[i];
+            if(slot.hash == hash && this->names[slot.atom] == name)
+                return slot.atom;
+        }
+
+        return ULANG_ATOM_NONE;
+    }
+
+    uint32_t NameTable::intern(std::string_view name) {
+        uint32_t atom = this->find(name);
+        if(atom != ULANG_ATOM_NONE)
+            return atom;
+
+        // at most half full
+        if((this->names.size() + 1) * 2 > this->slots.size())
+            this->grow();
+
+        uint32_t hash = static_cast<uint32_t>(std::hash<std::string_view>{}(name));
+        size_t mask = this->slots.size() - 1;
+
+        size_t i = hash & mask;
+        while(this->slots[i].atom != ULANG_ATOM_NONE)
+            i = (i + 1) & mask;
+
+        atom = static_cast<uint32_t>(this->names.size());
+        this->names.emplace_back(name);
+        this->slots[i] = {hash, atom};
+
+        return atom;
+    }
+
+    SymbolTable::SymbolTable() {
+        this->scope_global = nullptr;
+        this->scope_current = nullptr;
+
+        this->scope_global = this->enter("<global>");
         this->scope_global->nextOffset = 16;
+    }
 
-        this->scope_current = this->scope_global;
+    size_t SymbolTable::bindingHash(uint32_t scope, uint32_t atom) {
+        uint64_t key = (static_cast<uint64_t>(scope) << 32) | atom;
+        key *= 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(key ^ (key >> 32));
     }
 
-    SymbolTable::~SymbolTable() {
-        /*
-        Scope* s = this->scope_current;
-        while(s) {
-            Scope* parent = s->parent;
-            delete s;
+    void SymbolTable::growBindings() {
+        std::vector<Binding> old = std::move(this->bindings);
+        this->bindings.assign(old.empty() ? BINDING_MIN_SLOTS : old.size() * 2, {0, 0, UINT32_MAX});
 
-            s = parent;
+        size_t mask = this->bindings.size() - 1;
+        for(const Binding& b: old) {
+            if(b.symbol == UINT32_MAX)
+                continue;
+
+            size_t i = bindingHash(b.scope, b.atom) & mask;
+            while(this->bindings[i].symbol != UINT32_MAX)
+                i = (i + 1) & mask;
+
+            this->bindings[i] = b;
+        }
+    }
+
+    Symbol* SymbolTable::find(uint32_t scope, uint32_t atom) const {
+        if(this->bindings.empty())
+            return nullptr;
+
+        size_t mask = this->bindings.size() - 1;
+        for(size_t i = bindingHash(scope, atom) & mask; this->bindings[i].symbol != UINT32_MAX; i = (i + 1) & mask) {
+            const Binding& b = this->bindings[i];
+            if(b.scope == scope && b.atom == atom)
+                return const_cast<Symbol*>(&this->symbol_list[b.symbol]);
         }
-        */
 
-        delete this->scope_global;
+        return nullptr;
+    }
+
+    Symbol* SymbolTable::bind(Scope* scope, const std::string& name, const char* what) {
+        uint32_t atom = this->names.intern(name);
+        if(this->find(scope->index, atom))
+            throw std::runtime_error(std::string(what) + " already declared in '" + scope->_name + "' scope: " + name);
+
+        // at most half full
+        if((this->binding_count + 1) * 2 > this->bindings.size())
+            this->growBindings();
+
+        uint32_t index = static_cast<uint32_t>(this->symbol_list.size());
+        Symbol& sym = this->symbol_list.emplace_back(this->names.name(atom), atom);
+        sym.scope = scope->index;
+        sym.symbolId = ULANG_SYMBOL_ID_BASE + index;
+
+        size_t mask = this->bindings.size() - 1;
+        size_t i = bindingHash(scope->index, atom) & mask;
+        while(this->bindings[i].symbol != UINT32_MAX)
+            i = (i + 1) & mask;
+
+        this->bindings[i] = {scope->index, atom, index};
+        this->binding_count++;
+
+        scope->symbols.push_back(&sym);
+        return &sym;
     }
 
     Scope* SymbolTable::enter(const std::string& name) {
-        Scope* s = new Scope;
+        std::unique_ptr<Scope> s = std::make_unique<Scope>();
         s->_name = name;
+        s->table = this;
+        s->index = static_cast<uint32_t>(this->scopes.size());
         s->parent = this->scope_current;
-        s->nextOffset = this->scope_current->nextOffset;
+        s->nextOffset = s->parent ? s->parent->nextOffset : 0;
+        s->ci_ptr = s->parent ? s->parent->ci_ptr : nullptr;
 
-        s->ci_ptr = s->parent->ci_ptr;
+        this->scope_current = s.get();
+        this->scopes.push_back(std::move(s));
 
-        this->scope_current = s;
-        return s;
+        return this->scope_current;
     }
 
     Scope* SymbolTable::leave() {
         if(this->scope_current->parent == nullptr)
             throw std::runtime_error("Cannot exit global scope");
 
-        Scope* old = this->scope_current;
+        // the scope stays alive, the AST still points at its symbols
         this->scope_current = this->scope_current->parent;
-        
-        delete old;
-
         return this->scope_current;
     }
 
     Symbol* SymbolTable::decl(const std::string& name, const DataType* type, SourceLocation* loc, size_t align_head, size_t align_tail) {
-        Symbol* sym = this->scope_current->decl(name, type, loc, align_head, align_tail);
-        sym->symbolId = this->nextSymbolId++;
-
-        //std::cout << "decl: " << type->name << " " << name << " in scope '" << this->scope_current->_name << "' @ vstack: " << sym->stackOffset << std::endl;
-
-        return sym;
+        return this->scope_current->decl(name, type, loc, align_head, align_tail);
     }
 
     Symbol* SymbolTable::decl_fn(const std::string& name, const DataType* type, SourceLocation* loc, size_t align_head, size_t align_tail) {
-        Symbol* sym = this->scope_current->decl_fn(name, type, loc, align_head, align_tail);
-        sym->symbolId = this->nextSymbolId++;
+        return this->scope_current->decl_fn(name, type, loc, align_head, align_tail);
+    }
 
-        //std::cout << "decl: " << type->name << " " << name << " in scope '" << this->scope_current->_name << "' @ vstack: " << sym->stackOffset << std::endl;
+    const Symbol* SymbolTable::lookupFrom(const Scope* scope, std::string_view name) const {
+        uint32_t atom = this->names.find(name);
+        if(atom == ULANG_ATOM_NONE)
+            return nullptr;
 
-        return sym;
+        for(; scope; scope = scope->parent) {
+            if(const Symbol* sym = this->find(scope->index, atom))
+                return sym;
+        }
+
+        return nullptr;
     }
 
-    const Symbol* SymbolTable::lookup(const std::string& name) const {
-        return this->scope_current->lookup(name);
+    const Symbol* SymbolTable::lookup(std::string_view name) const {
+        return this->lookupFrom(this->scope_current, name);
     }
 
     const Symbol* SymbolTable::lookup(unsigned int symbolId) const {
-        return this->scope_current->lookup(symbolId);
-    }
+        if(symbolId < ULANG_SYMBOL_ID_BASE || symbolId - ULANG_SYMBOL_ID_BASE >= this->symbol_list.size())
+            return nullptr;
 
-    Scope::~Scope() {
-        
+        return &this->symbol_list[symbolId - ULANG_SYMBOL_ID_BASE];
     }
     
     Scope* SymbolTable::getCurrentScope() const {
@@ -88,4 +198,4 @@ namespace ULang {
     Scope* SymbolTable::getGlobalScope() const {
         return this->scope_global;
     }
-}
\ No newline at end of file
+}
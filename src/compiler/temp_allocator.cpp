@@ -7,7 +7,7 @@
 #include <string>
 
 #define cout_verbose        \
-    if(this->cparams.verbose)    \
+    if(ULANG_TRACE_ENABLED && this->cparams.verbose)    \
         std::cout
 
 namespace ULang {
@@ -15,7 +15,7 @@ namespace ULang {
         for(uint32_t i = 0; i < this->tmp_used.size(); i++) {
             if(!this->tmp_used[i]) {
                 this->tmp_used[i] = true;
-                this->verbose_nl("* allocTmpReg -> TMP" + std::to_string(i), true);
+                TRACE_NL("* allocTmpReg -> TMP" + std::to_string(i), true);
                 return {OperandType::OP_REGISTER, R_TMP0.reg_no + i};
             }
         }
@@ -26,7 +26,7 @@ namespace ULang {
     void CompilerInstance::freeTmpReg(uint8_t reg, bool failsafe) {
         if(reg >= this->tmp_used.size()) {
             if(failsafe) {
-                this->verbose_nl("* FAILSAFE freeTmpReg TMP" + std::to_string(reg), true);
+                TRACE_NL("* FAILSAFE freeTmpReg TMP" + std::to_string(reg), true);
                 return;
             };
 
@@ -34,13 +34,13 @@ namespace ULang {
         }
 
         this->tmp_used[reg] = false;
-        this->verbose_nl("* OK freeTmpReg TMP" + std::to_string(reg), true);
+        TRACE_NL("* OK freeTmpReg TMP" + std::to_string(reg), true);
     }
 
     void CompilerInstance::freeTmpReg(Operand reg, bool failsafe) {
         if(reg.type != OperandType::OP_REGISTER || reg.data < R_TMP0.reg_no || reg.data >= R_TMP0.reg_no + this->tmp_used.size()) {
             if(failsafe) {
-                this->verbose_nl("* FAILSAFE freeTmpReg TMP" + std::to_string(reg.data - R_TMP0.reg_no), true);
+                TRACE_NL("* FAILSAFE freeTmpReg TMP" + std::to_string(reg.data - R_TMP0.reg_no), true);
                 return;
             };
 
@@ -48,7 +48,7 @@ namespace ULang {
         }
 
         this->tmp_used[reg.data - R_TMP0.reg_no] = false;
-        this->verbose_nl("* OK freeTmpReg TMP" + std::to_string(reg.data - R_TMP0.reg_no), true);
+        TRACE_NL("* OK freeTmpReg TMP" + std::to_string(reg.data - R_TMP0.reg_no), true);
     }
 };
 
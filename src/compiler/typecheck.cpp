@@ -0,0 +1,229 @@
+#include "compiler.hpp"
+#include "compiler/errno.h"
+#include "types.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace ULang {
+    void CompilerInstance::checkOperandTypes(const DataType* left, const DataType* right, const std::string& what, SourceLocation loc) {
+        if((left->flags & SIGN) != (right->flags & SIGN)) {
+            this->friendlyException(CompilerSyntaxException(
+                CompilerSyntaxException::Severity::Warning,
+                what + " '" + left->name + "' and '" + right->name + "' differ in signedness",
+                loc,
+                ULANG_SYNT_WARN_TYPES_SIGN_DIFF
+            ));
+        }
+
+        if(left->size != right->size) {
+            this->friendlyException(CompilerSyntaxException(
+                CompilerSyntaxException::Severity::Warning,
+                what + " '" + left->name + "' and '" + right->name + "' differ in sizes",
+                loc,
+                ULANG_SYNT_WARN_TYPES_SIZE_DIFF
+            ));
+        }
+    }
+
+    void CompilerInstance::annotateType(ASTNode* node) {
+        switch(node->type) {
+            // literals adapt to the other operand
+            case ASTNodeType::NUMBER:
+                node->value_type = nullptr;
+                break;
+
+            case ASTNodeType::FN_ARG:
+            case ASTNodeType::VARIABLE:
+            case ASTNodeType::FN_CALL:
+                if(!node->symbol) {
+                    throw CompilerSyntaxException(
+                        CompilerSyntaxException::Severity::Error,
+                        "Could not determine type for '" + node->name() + "'",
+                        ULANG_LOCATION_NULL,
+                        ULANG_SYNT_ERR_TYPE_DETERMINE_FAIL
+                    );
+                }
+
+                if(node->symbol->kind == SymbolKind::FUNCTION && !node->symbol->defined) {
+                    throw CompilerSyntaxException(
+                        CompilerSyntaxException::Severity::Error,
+                        "function '" + node->name() + "' declared but never defined",
+                        node->symbol->where,
+                        ULANG_SYNT_ERR_FN_UNDEFINED
+                    );
+                }
+
+                node->value_type = node->symbol->type;
+                break;
+
+            case ASTNodeType::BINOP: {
+                const DataType* left  = node->lefthand->value_type;
+                const DataType* right = node->righthand->value_type;
+
+                if(left && right) {
+                    this->checkOperandTypes(left, right, "Operand types", node->lefthand->symbol ? node->lefthand->symbol->where : ULANG_LOCATION_NULL);
+                    node->value_type = this->determineBinopType(left, right);
+                } else node->value_type = left ? left : right;
+
+                break;
+            }
+
+            case ASTNodeType::ASSIGNMENT:
+                node->value_type = node->righthand ? node->righthand->value_type : nullptr;
+                break;
+
+            case ASTNodeType::DECLARATION: {
+                const DataType* init_type = node->initial ? node->initial->value_type : nullptr;
+                if(init_type)
+                    this->checkOperandTypes(init_type, node->symbol->type, "Types", node->symbol->where);
+
+                node->value_type = node->symbol->type;
+                break;
+            }
+
+            case ASTNodeType::FN_RET:
+                node->value_type = node->initial ? node->initial->value_type : nullptr;
+                break;
+
+            case ASTNodeType::FN_DEF:
+                node->value_type = node->symbol ? node->symbol->type : nullptr;
+                break;
+        }
+    }
+
+    const DataType* CompilerInstance::inferType(ASTNode* node) {
+        if(!node)
+            return nullptr;
+
+        // post-order walk, children are pushed in reverse so that warnings come out in source order
+        std::vector<std::pair<ASTNode*, bool>> stack = {{node, false}};
+
+        while(!stack.empty()) {
+            auto [n, children_done] = stack.back();
+            stack.pop_back();
+
+            if(children_done) {
+                this->annotateType(n);
+                continue;
+            }
+
+            stack.push_back({n, true});
+
+            switch(n->type) {
+                case ASTNodeType::BINOP:
+                    stack.push_back({n->righthand, false});
+                    stack.push_back({n->lefthand, false});
+                    break;
+
+                case ASTNodeType::ASSIGNMENT:
+                    if(n->righthand)
+                        stack.push_back({n->righthand, false});
+                    break;
+
+                case ASTNodeType::DECLARATION:
+                case ASTNodeType::FN_RET:
+                    if(n->initial)
+                        stack.push_back({n->initial, false});
+                    break;
+
+                case ASTNodeType::FN_CALL:
+                case ASTNodeType::FN_DEF: {
+                    ASTList& children = n->type == ASTNodeType::FN_CALL ? n->args : n->body;
+
+                    size_t mark = stack.size();
+                    for(ASTNode* child: children)
+                        stack.push_back({child, false});
+                    std::reverse(stack.begin() + mark, stack.end());
+                    break;
+                }
+
+                default:
+                    break;
+            }
+        }
+
+        return node->value_type;
+    }
+
+    void CompilerInstance::contextType(ASTNode* node, const DataType* context) {
+        struct Pending {
+            ASTNode* node;
+            const DataType* context;    ///< type the value is used as, nullptr if nothing asks for one
+            const ASTNode* fn;          ///< enclosing function definition
+        };
+
+        // top-down, a literal subtree takes the type of whatever consumes it
+        std::vector<Pending> stack = {{node, context, nullptr}};
+
+        while(!stack.empty()) {
+            auto [n, ctx, fn] = stack.back();
+            stack.pop_back();
+
+            if(!n)
+                continue;
+
+            switch(n->type) {
+                case ASTNodeType::NUMBER:
+                    if(!n->value_type)
+                        n->value_type = ctx ? ctx : &TYPE_INT32;
+                    break;
+
+                case ASTNodeType::BINOP:
+                    if(!n->value_type)
+                        n->value_type = ctx ? ctx : &TYPE_INT32;
+
+                    // a typed operand already decided the type, its untyped sibling follows
+                    stack.push_back({n->righthand, n->value_type, fn});
+                    stack.push_back({n->lefthand, n->value_type, fn});
+                    break;
+
+                case ASTNodeType::ASSIGNMENT: {
+                    const DataType* target = n->lefthand && n->lefthand->symbol ? n->lefthand->symbol->type : nullptr;
+                    stack.push_back({n->righthand, target, fn});
+
+                    if(!n->value_type)
+                        n->value_type = target;
+                    break;
+                }
+
+                case ASTNodeType::DECLARATION:
+                    stack.push_back({n->initial, n->symbol->type, fn});
+                    break;
+
+                case ASTNodeType::FN_RET: {
+                    const DataType* ret = fn && fn->symbol ? fn->symbol->type : nullptr;
+                    stack.push_back({n->initial, ret, fn});
+
+                    if(!n->value_type)
+                        n->value_type = ret;
+                    break;
+                }
+
+                // parameter types are not known at the call site, arguments fall back to int32
+                case ASTNodeType::FN_CALL:
+                    for(ASTNode* arg: n->args)
+                        stack.push_back({arg, nullptr, fn});
+                    break;
+
+                case ASTNodeType::FN_DEF:
+                    for(ASTNode* child: n->body)
+                        stack.push_back({child, nullptr, n});
+                    break;
+
+                default:
+                    break;
+            }
+        }
+    }
+
+    void CompilerInstance::checkTypes() {
+        TRACE_NL("Type check");
+
+        for(ASTNode* node: this->ast_root) {
+            THROW_AWAY this->inferType(node);
+            this->contextType(node, nullptr);
+        }
+    }
+};
@@ -7,15 +7,42 @@
 #include <cstdlib>
 #include <iostream>
 #include "bytecode.hpp"
+#include "loader.hpp"
+#include "vm/io.hpp"
+#include "vm/simd.hpp"
 #include "vm/vmparams.hpp"
 #include "vmreg_defines.hpp"
 
+// FLAGS register bits, set by CMP/TEST
+#define ULANG_FLAG_ZF   (1 << 0)    ///< result is zero
+#define ULANG_FLAG_SF   (1 << 1)    ///< result is negative
+#define ULANG_FLAG_CF   (1 << 2)    ///< unsigned borrow
+#define ULANG_FLAG_OF   (1 << 3)    ///< signed overflow
+
 namespace ULang {
+    class ProgramStream;
+
     struct HeapBlockHdr {
         size_t size;
         HeapBlockHdr* next;
     };
 
+    /**
+     * @brief Result of an execution slice
+     */
+    enum class ExecStatus {
+        HALTED,     ///< program finished, output flushed
+        SUSPENDED   ///< waiting for a non-blocking I/O port, continue with VirtualMachine::resume()
+    };
+
+    /**
+     * @brief I/O port the suspended VM waits for
+     */
+    struct IOWait {
+        IOPort* port = nullptr;
+        bool output = false;    ///< waiting to write (true) or to read (false)
+    };
+
     class VirtualMachine {
         private:
         // bool verbose_en;
@@ -40,7 +67,8 @@ namespace ULang {
 
         size_t heapsize_tot = 0;
 
-        uint8_t* heap_base;             ///< Heap memory pool pointer
+        uint8_t* heap_base = nullptr;   ///< Heap memory pool pointer
+        size_t heap_dirty = 0;          ///< Bytes from heap_base that may be non-zero, heap_reset() clears only these
         
         /**
          * @brief Initializes the heap
@@ -48,6 +76,17 @@ namespace ULang {
          */
         void heap_init();
 
+        /**
+         * @brief Returns the heap to its just-initialized state without reallocating it, clearing only what was touched since
+         */
+        void heap_reset();
+
+        /**
+         * @brief Copies the static data image of the program over its globals
+         * @exception std::runtime_error if the image does not fit the heap
+         */
+        void heap_loadImage();
+
         /**
          * @brief Allocates the area in the memory pool
          * @exception std::runtime-error when allocation fails
@@ -71,9 +110,10 @@ namespace ULang {
          * @brief Converts virtual memory offset to real memory pointer
          * @exception std::runtime_error if heap reference out of bounds
          * @param offset offset in virtual memory
+         * @param size size of the accessed range in bytes (default: 8)
          * @return uint8_t* real memory pointer
          */
-        uint8_t* castHeapReference(uint64_t offset);
+        uint8_t* castHeapReference(uint64_t offset, uint64_t size = sizeof(uint64_t));
 
         // ==================================================================
         // ======== REGISTERS
@@ -82,6 +122,24 @@ namespace ULang {
         static constexpr uint32_t REG_COUNT = 32;
         uint64_t regs[REG_COUNT];   ///< register file
 
+        VReg vregs[ULANG_VREG_COUNT];           ///< vector register file
+        const SimdKernels* simd = nullptr;      ///< vector kernels picked for the host CPU
+
+        /**
+         * @brief Resolves vector register operand
+         * @exception std::runtime_error not a vector register
+         * @param op operand structure
+         * @return VReg& vector register
+         */
+        VReg& vregOperand(const Operand& op);
+
+        /**
+         * @brief Executes vector instruction according to the VTYPE register
+         * @exception std::runtime_error
+         * @param instr instruction structure
+         */
+        void executeVector(const Instruction& instr);
+
         // ==================================================================
         // ======== VM STATE + STACK
         // ==================================================================
@@ -92,7 +150,59 @@ namespace ULang {
         uint64_t* flags;    ///< execution flags register pointer
 
         static constexpr size_t STACK_SIZE = 256 * 1024;
-        uint8_t* stack;
+        uint8_t* stack = nullptr;   ///< SP is an offset into it, grows down from STACK_SIZE
+
+        /**
+         * @brief Pushes a value on the stack
+         * @exception std::runtime_error on stack overflow
+         */
+        void stack_push(uint64_t val);
+
+        /**
+         * @brief Pops a value from the stack
+         * @exception std::runtime_error on stack underflow
+         */
+        uint64_t stack_pop();
+
+        /**
+         * @brief Evaluates the condition of a conditional jump against FLAGS
+         * @param op conditional jump opcode
+         * @return true if the jump is taken
+         */
+        bool condition(Opcode op) const;
+
+        bool running = false;
+
+        ProgramData data;   ///< data section of the loaded file (constant pool, static data image)
+
+        ProgramStream* stream = nullptr;    ///< source of code still being loaded, nullptr if the program is complete
+        size_t code_ready = SIZE_MAX;       ///< instructions known to be decoded
+
+        // ==================================================================
+        // ======== I/O
+        // ==================================================================
+
+        IOChannels io;      ///< I/O ports (PUTC/GETC use stdout/stdin port)
+        IOWait io_wait;     ///< port the execution is suspended on
+
+        /**
+         * @brief Suspends the execution until the port is ready, the current instruction is executed again on resume
+         * @param port port which would block
+         * @param output whether waiting to write
+         */
+        void io_suspend(IOPort& port, bool output);
+
+        /**
+         * @brief Blocks until the port the VM is suspended on is ready
+         * @exception std::runtime_error if the port can't be waited for
+         */
+        void io_waitReady();
+
+        /**
+         * @brief Sets up the I/O ports according to VM parameters
+         * @exception std::runtime_error invalid I/O parameters
+         */
+        void io_init();
 
         // ==================================================================
         // ======== EXECUTION
@@ -122,6 +232,34 @@ namespace ULang {
          */
         void writeOpCast(const Operand& op, uint64_t val);
 
+        /**
+         * @brief Resolves the memory range addressed by operand (&offset or register holding the offset)
+         * @exception std::runtime_error invalid operand type or range out of bounds
+         * @param op operand structure
+         * @param size size of the range in bytes
+         * @return uint8_t* real memory pointer
+         */
+        uint8_t* castOperandAddress(const Operand& op, uint64_t size);
+
+        /**
+         * @brief Loads 1/2/4 bytes from memory addressed by operand, extended to 64 bits
+         * @exception std::runtime_error invalid operand type or range out of bounds
+         * @param op operand structure
+         * @param size access width in bytes
+         * @param sign sign-extend (true) or zero-extend (false)
+         * @return uint64_t loaded value
+         */
+        uint64_t loadSized(const Operand& op, size_t size, bool sign);
+
+        /**
+         * @brief Stores low 1/2/4 bytes of the value to memory addressed by operand
+         * @exception std::runtime_error invalid operand type or range out of bounds
+         * @param op operand structure
+         * @param size access width in bytes
+         * @param val value
+         */
+        void storeSized(const Operand& op, size_t size, uint64_t val);
+
         public:
         //VirtualMachine(bool verbose_en, size_t heapsize_start_kb, size_t heapsize_limit_kb)
         //    : verbose_en(verbose_en), heapsize_start_kb(heapsize_start_kb), heapsize_limit_kb(heapsize_limit_kb) {};
@@ -138,8 +276,55 @@ namespace ULang {
         };
 
         void init();
-        void run(const std::vector<Instruction> program);
+
+        /**
+         * @brief Resets registers, stack and heap so the next run starts from a clean state
+         */
+        void reset();
+
+        /**
+         * @brief Runs the program to completion, blocking on I/O if needed
+         * @exception std::runtime_error
+         * @param program decoded program
+         */
+        void run(const std::vector<Instruction>& program);
+
+        /**
+         * @brief Starts the program, returns early if a non-blocking I/O port would block
+         * @exception std::runtime_error
+         * @param program decoded program
+         * @return ExecStatus
+         */
+        ExecStatus start(const std::vector<Instruction>& program);
+
+        /**
+         * @brief Continues a suspended program
+         * @exception std::runtime_error
+         * @param program decoded program (the same one as passed to start())
+         * @return ExecStatus
+         */
+        ExecStatus resume(const std::vector<Instruction>& program);
+
+        /**
+         * @brief Stops the execution and flushes all the I/O ports
+         * @exception std::runtime_error on I/O error
+         */
         void halt();
+
+        /**
+         * @brief Attaches the data section of the program and loads its static data image, the buffer it points into must outlive the VM
+         * @exception std::runtime_error if the image does not fit the heap
+         */
+        void setData(const ProgramData& data) {this->data = data; this->heap_loadImage();};
+
+        /**
+         * @brief Makes the interpreter wait for instructions the stream has not decoded yet
+         * @param stream program source, nullptr when the program is complete
+         */
+        void setStream(ProgramStream* stream) {this->stream = stream; this->code_ready = stream ? 0 : SIZE_MAX;};
+
+        IOChannels& getIO() {return this->io;};
+        const IOWait& getIOWait() const {return this->io_wait;};
     };
 };
 
@@ -0,0 +1,64 @@
+#include "batch.hpp"
+#include "vmstat.hpp"
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace ULang {
+    size_t runBatch(VirtualMachine& vm, const std::vector<Instruction>& program, const VMParams& vmparams) {
+        std::ifstream fin;
+        std::istream in(std::cin.rdbuf());
+
+        if(vmparams.batchFile != "-") {
+            fin.open(vmparams.batchFile, std::ios::binary);
+            if(!fin)
+                throw std::runtime_error("Cannot open batch file: " + vmparams.batchFile);
+
+            in.rdbuf(fin.rdbuf());
+        }
+
+        IOPort& port_in  = vm.getIO().port(ULANG_IO_PORT_STDIN);
+        IOPort& port_out = vm.getIO().port(ULANG_IO_PORT_STDOUT);
+
+        uint64_t records = 0;
+        uint64_t bytes = 0;
+        size_t failed = 0;
+
+        StatTimeMeter meter;
+        meter.start();
+
+        std::string record;
+        while(std::getline(in, record, vmparams.batchDelim)) {
+            // the last record may end without a delimiter
+            bytes += record.size() + (in.eof() ? 0 : 1);
+            port_in.setBackend(std::make_unique<IOMemoryBackend>(std::move(record)));
+
+            try {
+                vm.reset();
+                vm.run(program);
+            } catch(std::exception& e) {
+                std::cerr << "BATCH: record " << records << ": " << e.what() << std::endl;
+                failed++;
+            }
+
+            port_out.putc(vmparams.batchDelim);
+            records++;
+        }
+
+        vm.getIO().flushAll();
+
+        meter.stop();
+
+        uint64_t us = meter.microseconds();
+        double secs = us > 0 ? us / 1e6 : 1e-6;
+
+        std::cerr   << "BATCH: " << records << " records (" << failed << " failed), " << bytes << " bytes in " << us << " us: "
+                    << static_cast<uint64_t>(records / secs) << " records/s, "
+                    << static_cast<uint64_t>(bytes / secs / 1024) << " kB/s" << std::endl;
+
+        return failed;
+    }
+};
@@ -0,0 +1,26 @@
+#ifndef __ULANG_BATCH_H
+#define __ULANG_BATCH_H
+
+#include <vector>
+#include "bytecode.hpp"
+#include "vm/VirtualMachine.hpp"
+#include "vm/vmparams.hpp"
+
+namespace ULang {
+    /**
+     * @brief Runs a single loaded program over every record of a streamed input file.
+     *
+     * Records are separated by VMParams::batchDelim. Each record becomes the stdin port input
+     * (GETC) of one run, VM state is reset between the runs. The output of every run is
+     * terminated by the same delimiter. Batch throughput is reported to stderr.
+     *
+     * @exception std::runtime_error when the record file can not be opened
+     * @param vm initialized virtual machine
+     * @param program decoded program
+     * @param vmparams VM parameters (record file in VMParams::batchFile, "-" for stdin)
+     * @return size_t count of records whose run failed
+     */
+    size_t runBatch(VirtualMachine& vm, const std::vector<Instruction>& program, const VMParams& vmparams);
+};
+
+#endif
@@ -0,0 +1,92 @@
+#include "forkserver.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t forksrv_stop = 0;
+
+static void forksrv_onSignal(int sig) {
+    (void) sig;
+    forksrv_stop = 1;
+}
+
+namespace ULang {
+    void forkServer(VirtualMachine& vm, const std::vector<Instruction>& program, const VMParams& vmparams) {
+        const std::string& path = vmparams.forkServerSocket;
+        int sock = ioListenUnix(path);
+
+        // no SA_RESTART: accept() has to be interrupted to notice the stop request
+        struct sigaction sa {};
+        sa.sa_handler = forksrv_onSignal;
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGINT, &sa, nullptr);
+        sigaction(SIGTERM, &sa, nullptr);
+
+        // children are never waited for, let the kernel reap them
+        signal(SIGCHLD, SIG_IGN);
+
+        if(vmparams.verbose_en)
+            std::cout << "FORKSRV: listening on " << path << std::endl;
+
+        while(!forksrv_stop) {
+            int conn = accept(sock, nullptr, nullptr);
+            if(conn < 0) {
+                if(errno == EINTR || errno == ECONNABORTED)
+                    continue;
+
+                std::cerr << "FORKSRV: accept failed: " << std::strerror(errno) << std::endl;
+                break;
+            }
+
+            // anything buffered now would be written twice
+            std::cout.flush();
+            std::cerr.flush();
+
+            pid_t pid = fork();
+            if(pid < 0) {
+                std::cerr << "FORKSRV: fork failed: " << std::strerror(errno) << std::endl;
+                close(conn);
+                continue;
+            }
+
+            if(pid == 0) {
+                close(sock);
+
+                dup2(conn, STDIN_FILENO);
+                dup2(conn, STDOUT_FILENO);
+                close(conn);
+
+                signal(SIGINT, SIG_DFL);
+                signal(SIGTERM, SIG_DFL);
+                signal(SIGCHLD, SIG_DFL);
+
+                int rc = 0;
+                try {
+                    vm.run(program);
+                } catch(std::exception& e) {
+                    std::cerr << e.what() << std::endl;
+                    rc = 1;
+                }
+
+                std::cout.flush();
+                _exit(rc);
+            }
+
+            if(vmparams.verbose_en)
+                std::cout << "FORKSRV: connection served by pid " << pid << std::endl;
+
+            close(conn);
+        }
+
+        close(sock);
+        unlink(path.c_str());
+
+        if(vmparams.verbose_en)
+            std::cout << "FORKSRV: stopped" << std::endl;
+    }
+};
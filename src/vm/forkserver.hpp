@@ -0,0 +1,27 @@
+#ifndef __ULANG_FORKSERVER_H
+#define __ULANG_FORKSERVER_H
+
+#include <vector>
+#include "bytecode.hpp"
+#include "vm/VirtualMachine.hpp"
+#include "vm/vmparams.hpp"
+
+namespace ULang {
+    /**
+     * @brief Serves repeated executions of a single loaded program over a local UNIX socket.
+     *
+     * The program is decoded and the VM initialized only once. Every accepted connection
+     * gets a copy-on-write child process with the connection as its stdin and stdout,
+     * so the parsing, decoding and heap setup costs are not paid per execution.
+     *
+     * Returns when SIGINT or SIGTERM is received.
+     *
+     * @exception std::runtime_error when the socket can not be set up
+     * @param vm initialized virtual machine
+     * @param program decoded program
+     * @param vmparams VM parameters (socket path in VMParams::forkServerSocket)
+     */
+    void forkServer(VirtualMachine& vm, const std::vector<Instruction>& program, const VMParams& vmparams);
+};
+
+#endif
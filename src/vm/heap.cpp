@@ -1,7 +1,9 @@
 #include "VirtualMachine.hpp"
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
 
@@ -17,15 +19,39 @@ namespace ULang {
         this->heap_base = reinterpret_cast<uint8_t*>(malloc(bytes));
         if(!this->heap_base)
             throw std::runtime_error("Could not allocate starting block for heap");
-        
+
+        // malloc() does not clear
+        this->heapsize_tot = bytes;
+        this->heap_dirty = bytes;
+        this->heap_reset();
+    }
+
+    void VirtualMachine::heap_reset() {
+        memset(this->heap_base, 0x00, this->heap_dirty);
+
         this->heap_start = reinterpret_cast<HeapBlockHdr*>(this->heap_base);
-        this->heap_start->size = bytes - sizeof(HeapBlockHdr);
+        this->heap_start->size = this->heapsize_tot - sizeof(HeapBlockHdr);
         this->heap_start->next = nullptr;
+        this->heap_dirty = sizeof(HeapBlockHdr);
 
         this->heap_freelist = heap_start;
-
-        this->heapsize_tot = bytes;
         this->heapsize_current = sizeof(HeapBlockHdr);
+
+        this->heap_loadImage();
+    }
+
+    void VirtualMachine::heap_loadImage() {
+        if(!this->data.image)
+            return;
+
+        if(this->data.image_base > this->heapsize_tot || this->data.image_size > this->heapsize_tot - this->data.image_base)
+            throw std::runtime_error("Static data image does not fit the heap");
+
+        memcpy(this->heap_base + this->data.image_base, this->data.image, this->data.image_size);
+        this->heap_dirty = std::max(this->heap_dirty, size_t(this->data.image_base) + this->data.image_size);
+
+        if(this->vmparams.verbose_en)
+            std::cout << "HEAP: static data image: " << this->data.image_size << " bytes at " << std::hex << this->data.image_base << std::dec << "h" << std::endl;
     }
 
     void* VirtualMachine::heap_alloc(size_t size) {
@@ -41,6 +67,7 @@ namespace ULang {
 
                 current->size = size;
                 current->next = blk_new;
+                this->heap_dirty = std::max(this->heap_dirty, size_t((uint8_t*) blk_new + sizeof(HeapBlockHdr) - this->heap_base));
 
                 this->heapsize_current += blk_new->size;
                 void* result = (void*)((char*)current + sizeof(HeapBlockHdr));
@@ -92,10 +119,14 @@ namespace ULang {
         }
     }
 
-    uint8_t* VirtualMachine::castHeapReference(uint64_t offset) {
-        if(offset >= this->heapsize_tot)
+    uint8_t* VirtualMachine::castHeapReference(uint64_t offset, uint64_t size) {
+        if(offset > this->heapsize_tot || size > this->heapsize_tot - offset)
             throw std::runtime_error("Heap reference out of bounds");
 
+        // reads count too, the caller may write through the pointer
+        if(offset + size > this->heap_dirty)
+            this->heap_dirty = offset + size;
+
         return this->heap_base + offset;
     }
 };
\ No newline at end of file
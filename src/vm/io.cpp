@@ -0,0 +1,222 @@
+#include "io.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ULang {
+    IOFlushPolicy ioFlushPolicyFromStr(const std::string& str) {
+        if(str == "line") return IOFlushPolicy::LINE;
+        if(str == "size") return IOFlushPolicy::SIZE;
+        if(str == "halt") return IOFlushPolicy::HALT;
+
+        throw std::runtime_error("Unknown I/O flush policy: " + str);
+    }
+
+    int ioListenUnix(const std::string& path) {
+        sockaddr_un addr {};
+        addr.sun_family = AF_UNIX;
+
+        if(path.size() >= sizeof(addr.sun_path))
+            throw std::runtime_error("Socket path too long: " + path);
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+        int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(sock < 0)
+            throw std::runtime_error(std::string("Could not create socket: ") + std::strerror(errno));
+
+        unlink(path.c_str()); // stale socket from previous run
+
+        if(bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(sock, SOMAXCONN) < 0) {
+            int err = errno;
+            close(sock);
+            throw std::runtime_error("Could not listen on " + path + ": " + std::strerror(err));
+        }
+
+        return sock;
+    }
+
+    // ==================================================================
+    // ======== BACKENDS
+    // ==================================================================
+
+    size_t IOFdBackend::read(uint8_t* buf, size_t n) {
+        while(true) {
+            ssize_t res = ::read(this->fd, buf, n);
+            if(res >= 0)
+                return static_cast<size_t>(res);
+
+            if(errno == EAGAIN || errno == EWOULDBLOCK)
+                return ULANG_IO_BACKEND_WOULD_BLOCK;
+
+            if(errno != EINTR)
+                throw std::runtime_error(std::string("I/O read failed: ") + std::strerror(errno));
+        }
+    }
+
+    size_t IOFdBackend::write(const uint8_t* buf, size_t n) {
+        size_t done = 0;
+
+        while(done < n) {
+            ssize_t res = ::write(this->fd, buf + done, n - done);
+            if(res < 0) {
+                if(errno == EINTR)
+                    continue;
+                if(errno == EAGAIN || errno == EWOULDBLOCK)
+                    break;
+
+                throw std::runtime_error(std::string("I/O write failed: ") + std::strerror(errno));
+            }
+
+            done += res;
+        }
+
+        return done;
+    }
+
+    size_t IOStreamBackend::read(uint8_t* buf, size_t n) {
+        if(!this->in)
+            throw std::runtime_error("I/O port not readable");
+
+        // take what is already buffered, block for a single byte otherwise
+        std::streamsize avail = this->in->rdbuf()->in_avail();
+        if(avail > 0) {
+            this->in->read(reinterpret_cast<char*>(buf), std::min<std::streamsize>(avail, n));
+            return this->in->gcount();
+        }
+
+        int ch = this->in->get();
+        if(ch == EOF)
+            return 0;
+
+        buf[0] = static_cast<uint8_t>(ch);
+        return 1;
+    }
+
+    size_t IOStreamBackend::write(const uint8_t* buf, size_t n) {
+        if(!this->out)
+            throw std::runtime_error("I/O port not writeable");
+
+        this->out->write(reinterpret_cast<const char*>(buf), n);
+        this->out->flush();
+
+        return n;
+    }
+
+    size_t IOMemoryBackend::read(uint8_t* buf, size_t n) {
+        n = std::min(n, this->data_in.size() - this->pos);
+        std::memcpy(buf, this->data_in.data() + this->pos, n);
+        this->pos += n;
+
+        return n;
+    }
+
+    size_t IOMemoryBackend::write(const uint8_t* buf, size_t n) {
+        this->data_out.append(reinterpret_cast<const char*>(buf), n);
+        return n;
+    }
+
+    // ==================================================================
+    // ======== PORTS
+    // ==================================================================
+
+    void IOPort::setup(std::unique_ptr<IOBackend> backend, IOFlushPolicy policy, size_t bufsize) {
+        if(bufsize == 0)
+            throw std::runtime_error("I/O buffer size must not be zero");
+
+        this->backend = std::move(backend);
+        this->policy = policy;
+
+        this->buf_in.assign(bufsize, 0);
+        this->in_pos = this->in_len = 0;
+
+        this->buf_out.assign(bufsize, 0);
+        this->out_len = 0;
+    }
+
+    void IOPort::setBackend(std::unique_ptr<IOBackend> backend) {
+        this->backend = std::move(backend);
+        this->in_pos = this->in_len = 0;
+    }
+
+    int IOPort::getc() {
+        if(this->in_pos >= this->in_len) {
+            if(!this->backend)
+                throw std::runtime_error("I/O port not connected");
+
+            if(this->tied && this->tied->policy == IOFlushPolicy::LINE)
+                (void) this->tied->flush();
+
+            size_t len = this->backend->read(this->buf_in.data(), this->buf_in.size());
+            if(len == ULANG_IO_BACKEND_WOULD_BLOCK)
+                return ULANG_IO_WOULD_BLOCK;
+
+            this->in_len = len;
+            this->in_pos = 0;
+
+            if(this->in_len == 0)
+                return ULANG_IO_EOF;
+        }
+
+        return this->buf_in[this->in_pos++];
+    }
+
+    bool IOPort::putc(uint8_t ch) {
+        if(this->out_len >= this->buf_out.size()) {
+            if(this->policy == IOFlushPolicy::HALT)
+                this->buf_out.resize(this->buf_out.size() * 2);
+            else if(!this->flush() && this->out_len >= this->buf_out.size())
+                return false;
+        }
+
+        this->buf_out[this->out_len++] = ch;
+
+        // whatever does not fit into a non-blocking sink now stays buffered
+        if(this->policy == IOFlushPolicy::LINE && ch == '\n')
+            (void) this->flush();
+
+        return true;
+    }
+
+    bool IOPort::flush() {
+        if(this->out_len == 0)
+            return true;
+
+        if(!this->backend)
+            throw std::runtime_error("I/O port not connected");
+
+        size_t done;
+        try {
+            done = this->backend->write(this->buf_out.data(), this->out_len);
+        } catch(...) {
+            // drop the buffer so a failing backend can't make it flush again and again
+            this->out_len = 0;
+            throw;
+        }
+
+        if(done < this->out_len)
+            std::memmove(this->buf_out.data(), this->buf_out.data() + done, this->out_len - done);
+
+        this->out_len -= done;
+        return this->out_len == 0;
+    }
+
+    IOPort& IOChannels::port(uint64_t no) {
+        if(no >= ULANG_IO_PORT_COUNT)
+            throw std::runtime_error("Invalid I/O port: " + std::to_string(no));
+
+        return this->ports[no];
+    }
+
+    IOPort* IOChannels::flushAll() {
+        for(IOPort& port: this->ports) {
+            if(!port.flush())
+                return &port;
+        }
+
+        return nullptr;
+    }
+};
@@ -0,0 +1,202 @@
+#ifndef __ULANG_VMIO_H
+#define __ULANG_VMIO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define ULANG_IO_PORT_STDIN  0
+#define ULANG_IO_PORT_STDOUT 1
+#define ULANG_IO_PORT_STDERR 2
+#define ULANG_IO_PORT_COUNT  3
+
+#define ULANG_IO_EOF            (-1)            ///< IOPort::getc(): end of input
+#define ULANG_IO_WOULD_BLOCK    (-2)            ///< IOPort::getc(): no input available yet
+#define ULANG_IO_BACKEND_WOULD_BLOCK SIZE_MAX   ///< IOBackend::read(): no input available yet
+
+namespace ULang {
+    /**
+     * @brief When the buffered output of a port is written to its backend
+     */
+    enum class IOFlushPolicy {
+        LINE,   ///< on every newline and when the buffer is full
+        SIZE,   ///< when the buffer is full
+        HALT    ///< only when the VM halts (buffer grows as needed)
+    };
+
+    /**
+     * @brief Converts flush policy name ("line", "size", "halt") to IOFlushPolicy
+     * @exception std::runtime_error unknown policy name
+     */
+    IOFlushPolicy ioFlushPolicyFromStr(const std::string& str);
+
+    /**
+     * @brief Creates a UNIX stream socket listening on path (stale socket file is replaced)
+     * @exception std::runtime_error when the socket can not be set up
+     * @return int listening socket
+     */
+    int ioListenUnix(const std::string& path);
+
+    /**
+     * @brief Raw byte source/sink behind an I/O port
+     */
+    class IOBackend {
+        public:
+        virtual ~IOBackend() = default;
+
+        /**
+         * @brief Reads up to n bytes
+         * @exception std::runtime_error on I/O error
+         * @return size_t bytes read, 0 on end of input, ULANG_IO_BACKEND_WOULD_BLOCK if non-blocking and no data available
+         */
+        virtual size_t read(uint8_t* buf, size_t n) = 0;
+
+        /**
+         * @brief Writes up to n bytes
+         * @exception std::runtime_error on I/O error
+         * @return size_t bytes written, less than n only if non-blocking and the sink is full
+         */
+        virtual size_t write(const uint8_t* buf, size_t n) = 0;
+
+        /**
+         * @brief File descriptor to wait on when an operation would block, -1 if none
+         */
+        virtual int pollFd() const {return -1;};
+    };
+
+    /**
+     * @brief Backend doing direct read(2)/write(2) on a file descriptor
+     */
+    class IOFdBackend: public IOBackend {
+        private:
+        int fd;
+
+        public:
+        IOFdBackend(int fd): fd(fd) {};
+
+        size_t read(uint8_t* buf, size_t n) override;
+        size_t write(const uint8_t* buf, size_t n) override;
+        int pollFd() const override {return this->fd;};
+    };
+
+    /**
+     * @brief Backend over C++ streams (follows rdbuf() redirections)
+     */
+    class IOStreamBackend: public IOBackend {
+        private:
+        std::istream* in;
+        std::ostream* out;
+
+        public:
+        IOStreamBackend(std::istream* in, std::ostream* out): in(in), out(out) {};
+
+        size_t read(uint8_t* buf, size_t n) override;
+        size_t write(const uint8_t* buf, size_t n) override;
+    };
+
+    /**
+     * @brief Backend reading from and writing to memory buffers
+     */
+    class IOMemoryBackend: public IOBackend {
+        private:
+        std::string data_in;
+        size_t pos = 0;
+
+        std::string data_out;
+
+        public:
+        IOMemoryBackend(std::string input): data_in(std::move(input)) {};
+
+        size_t read(uint8_t* buf, size_t n) override;
+        size_t write(const uint8_t* buf, size_t n) override;
+
+        const std::string& output() const {return this->data_out;};
+    };
+
+    /**
+     * @brief Buffered byte channel
+     */
+    class IOPort {
+        private:
+        std::unique_ptr<IOBackend> backend;
+        IOFlushPolicy policy = IOFlushPolicy::LINE;
+
+        std::vector<uint8_t> buf_in;
+        size_t in_pos = 0;
+        size_t in_len = 0;
+
+        std::vector<uint8_t> buf_out;
+        size_t out_len = 0;
+
+        IOPort* tied = nullptr;     ///< port flushed before this one blocks on input
+
+        public:
+        /**
+         * @brief (Re)configures the port, drops buffered input
+         * @param backend byte source/sink
+         * @param policy output flush policy
+         * @param bufsize buffer size in bytes
+         */
+        void setup(std::unique_ptr<IOBackend> backend, IOFlushPolicy policy, size_t bufsize);
+
+        /**
+         * @brief Replaces the backend, drops buffered input and keeps buffered output
+         */
+        void setBackend(std::unique_ptr<IOBackend> backend);
+
+        void tie(IOPort* port) {this->tied = port;};
+
+        /**
+         * @brief Reads a single byte
+         * @exception std::runtime_error on I/O error
+         * @return int byte value, ULANG_IO_EOF on end of input or ULANG_IO_WOULD_BLOCK
+         */
+        int getc();
+
+        /**
+         * @brief Writes a single byte, flushing according to the policy
+         * @exception std::runtime_error on I/O error
+         * @return false if the buffer is full and the backend would block (byte not written)
+         */
+        bool putc(uint8_t ch);
+
+        /**
+         * @brief Writes the buffered output to the backend
+         * @exception std::runtime_error on I/O error or port without backend
+         * @return false if the backend would block before everything was written
+         */
+        bool flush();
+
+        /**
+         * @brief File descriptor to wait on when the port would block, -1 if none
+         */
+        int pollFd() const {return this->backend ? this->backend->pollFd() : -1;};
+    };
+
+    /**
+     * @brief Set of VM I/O ports addressed by OUT/IN
+     */
+    class IOChannels {
+        private:
+        IOPort ports[ULANG_IO_PORT_COUNT];
+
+        public:
+        /**
+         * @brief Get port by its number
+         * @exception std::runtime_error invalid port number
+         */
+        IOPort& port(uint64_t no);
+
+        /**
+         * @brief Flushes all the ports
+         * @exception std::runtime_error on I/O error
+         * @return IOPort* first port which would block, nullptr if all flushed
+         */
+        IOPort* flushAll();
+    };
+};
+
+#endif
@@ -1,64 +1,42 @@
 #include "bytecode.hpp"
+#include "crc32c.hpp"
+#include "loader.hpp"
 #include "vm/VirtualMachine.hpp"
+#include "vm/batch.hpp"
+#include "vm/forkserver.hpp"
+#include "vm/scheduler.hpp"
+#include "vm/stream.hpp"
 #include "vm/vmparams.hpp"
 #include <boost/program_options/value_semantic.hpp>
 #include <cstddef>
 #include <exception>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <unistd.h>
 #include <boost/program_options.hpp>
 
 namespace po = boost::program_options;
 using namespace ULang;
 
-Operand readOperand(const std::vector<uint8_t>& buf, size_t& pc) {
-    Operand op {};
-    if(pc + 2 > buf.size())
-        return op;
-
-    op.type = static_cast<OperandType>(buf[pc++]);
-    op.data = 0;
-
-    for(int i = 0; pc < buf.size(); i++)
-        op.data |= uint32_t(buf[pc++]) << (8 * i);
-
-    return op;
-}
-
-Instruction readInstruction(const std::vector<uint8_t>& buf, size_t& pc) {
-    Instruction instr {};
-    instr.offset = pc;
-
-    if(pc + 11 >= buf.size())
-        return instr;
-
-    instr.opcode = static_cast<Opcode>(buf[pc++]);
-
-    for(uint8_t i = 0; i < 2; ++i) {
-        Operand op{};
-        op.type = static_cast<OperandType>(buf[pc++]);
-        op.data = 0;
-
-        for(int b = 0; b < 4; b++)
-            op.data |= uint32_t(buf[pc++]) << (8 * b);
-
-        instr.operands.push_back(op);
-    }
-
-    return instr;
-}
-
 int main(int argc, char** argv) {
     VMParams vmparams;
 
     po::options_description desc("ULang Bytecode Dump");
     desc.add_options()
         ("help,h", "Show help")
-        ("file,f", po::value<std::string>(&vmparams.fileName), "Binary bytecode file")
+        ("file,f", po::value<std::string>(&vmparams.fileName), "Binary bytecode file ('-' to stream it from stdin, the program input follows it)")
         ("verbose,V", po::bool_switch(&vmparams.verbose_en)->default_value(false), "Enable verbose debug outputs")
         ("heapsize-start", po::value(&vmparams.heapsize_start_kb)->default_value(256), "Starting virtual memory size to allocate (in kB, default: 256)")
-        ("heapsize-limit", po::value(&vmparams.heapsize_limit_kb)->default_value(0), "Maximal virtual memory size to allocate (in kB, 0 for unlimited, default: 0)");
+        ("heapsize-limit", po::value(&vmparams.heapsize_limit_kb)->default_value(0), "Maximal virtual memory size to allocate (in kB, 0 for unlimited, default: 0)")
+        ("io-backend", po::value<std::string>(&vmparams.io_backend)->default_value("fd"), "I/O port backend: fd (direct read/write syscalls) or stream (C++ iostreams)")
+        ("io-flush", po::value<std::string>(&vmparams.io_flush)->default_value("line"), "Output flush policy: line, size (when buffer is full) or halt")
+        ("io-bufsize", po::value(&vmparams.io_bufsize_kb)->default_value(64), "I/O port buffer size (in kB, default: 64)")
+        ("fork-server", po::value<std::string>(&vmparams.forkServerSocket), "Load the program once, then listen on UNIX socket path and fork a child per connection (connection is its stdin/stdout)")
+        ("async-server", po::value<std::string>(&vmparams.asyncServerSocket), "Listen on UNIX socket path and serve every connection by its own VM context on a single thread, suspending contexts blocked on I/O")
+        ("batch", po::value<std::string>(&vmparams.batchFile), "Run the program once per record of file ('-' for stdin), resetting the VM between records")
+        ("batch-delim", po::value<char>(&vmparams.batchDelim)->default_value('\n', "\\n"), "Batch record delimiter for both input and output (default: newline)");
 
     po::variables_map vm;
     try {
@@ -74,24 +52,68 @@ int main(int argc, char** argv) {
         return 0;
     }
 
-    std::ifstream f(vmparams.fileName, std::ios::binary);
-    if(!f) { 
-        std::cerr << "Cannot open file: " << vmparams.fileName << "\n"; 
-        return 1; 
+    bool from_stdin = vmparams.fileName == "-";
+    if(from_stdin && vmparams.batchFile == "-") {
+        std::cerr << "Program and batch records can't both be read from stdin\n";
+        return 1;
+    }
+
+    std::ifstream f;
+    if(!from_stdin) {
+        f.open(vmparams.fileName, std::ios::binary);
+        if(!f) { 
+            std::cerr << "Cannot open file: " << vmparams.fileName << "\n"; 
+            return 1; 
+        }
     }
 
     VirtualMachine vmachine(vmparams);
     
     try {
         vmachine.init();
-        
-        f.seekg(0, std::ios::end);
-        size_t size = f.tellg();
-        f.seekg(0, std::ios::beg);
 
-        std::vector<uint8_t> buf(size);
-        f.read(reinterpret_cast<char*>(buf.data()), size);
-        f.close();
+        std::vector<uint8_t> buf;
+
+        if(from_stdin) {
+            // the image is followed by the program input on the same pipe
+            ProgramStream stream(STDIN_FILENO);
+            stream.readHead();
+
+            bool plain = vmparams.forkServerSocket.empty() && vmparams.asyncServerSocket.empty() && vmparams.batchFile.empty();
+            if(plain && stream.streamable()) {
+                ProgramData data = loadData(stream.buffer(), stream.header());
+                vmachine.setData(data);
+
+                std::unique_ptr<IOBackend> in;
+                if(vmparams.io_backend == "stream")
+                    in = std::make_unique<IOStreamBackend>(&std::cin, nullptr);
+                else
+                    in = std::make_unique<IOFdBackend>(STDIN_FILENO);
+                vmachine.getIO().port(ULANG_IO_PORT_STDIN).setBackend(std::make_unique<IOStreamTailBackend>(stream, std::move(in)));
+
+                std::vector<Instruction> instructions;
+                stream.start(instructions);
+                vmachine.setStream(&stream);
+
+                if(vmparams.verbose_en)
+                    std::cout << "BOOT: Streaming " << instructions.size() << " instructions, constants: " << data.const_count << ", static data: " << data.image_size << " bytes" << std::endl;
+
+                vmachine.run(instructions);
+                stream.finish();
+                return 0;
+            }
+
+            stream.readAll();
+            buf.swap(stream.buffer());
+        } else {
+            f.seekg(0, std::ios::end);
+            size_t size = f.tellg();
+            f.seekg(0, std::ios::beg);
+
+            buf.resize(size);
+            f.read(reinterpret_cast<char*>(buf.data()), size);
+            f.close();
+        }
 
         if(buf.size() < sizeof(BytecodeHeader)) {
             std::cerr << "File smaller than header structure\n";
@@ -106,26 +128,34 @@ int main(int argc, char** argv) {
             return 1;
         }
 
-        std::vector<Instruction> instructions;
+        verifyChecksum(buf, hdr);
+        if(vmparams.verbose_en && hdr.checksum_type != BC_CHECKSUM_NONE)
+            std::cout << "BOOT: checksum " << std::hex << hdr.checksum << std::dec << "h valid (" << crc32cImpl() << ")" << std::endl;
 
-        size_t pc = hdr.code_offset;
-        while(pc < hdr.code_offset + hdr.code_size && pc < buf.size()) {
-            Instruction instr = readInstruction(buf, pc);
-            instructions.push_back(instr);
-        }
+        unpackSections(buf, hdr);
+        std::vector<Instruction> instructions = loadProgram(buf, hdr);
 
-        if(vmparams.verbose_en)
-            std::cout << "BOOT: Instructions read: " << instructions.size() << std::endl;
+        ProgramData data = loadData(buf, hdr);
+        vmachine.setData(data);
 
-        vmachine.run(instructions);
+        if(vmparams.verbose_en)
+            std::cout << "BOOT: Instructions read: " << instructions.size() << ", constants: " << data.const_count << ", static data: " << data.image_size << " bytes" << std::endl;
+
+        if(!vmparams.forkServerSocket.empty()) {
+            forkServer(vmachine, instructions, vmparams);
+        } else if(!vmparams.asyncServerSocket.empty()) {
+            asyncServer(instructions, data, vmparams);
+        } else if(!vmparams.batchFile.empty()) {
+            if(runBatch(vmachine, instructions, vmparams) > 0)
+                return 1;
+        } else {
+            vmachine.run(instructions);
+        }
 
     } catch(std::exception& e) {
         std::cerr << e.what() << std::endl;
-
-        f.close();
         return 1;
     };
 
-    f.close();
     return 0;
-}
\ No newline at end of file
+}
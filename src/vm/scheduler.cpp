@@ -0,0 +1,198 @@
+#include "scheduler.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define SCHED_EVENTS_MAX 64
+
+static volatile sig_atomic_t sched_stop = 0;
+
+static void sched_onSignal(int sig) {
+    (void) sig;
+    sched_stop = 1;
+}
+
+static void setNonblocking(int fd) {
+    int fl = fcntl(fd, F_GETFL, 0);
+    if(fl < 0 || fcntl(fd, F_SETFL, fl | O_NONBLOCK) < 0)
+        throw std::runtime_error(std::string("Could not make fd non-blocking: ") + std::strerror(errno));
+}
+
+namespace ULang {
+    VMScheduler::VMScheduler(const std::vector<Instruction>& program, const ProgramData& data, const VMParams& vmparams)
+    :   program(program), data(data), vmparams(vmparams) {
+        this->epfd = epoll_create1(EPOLL_CLOEXEC);
+        if(this->epfd < 0)
+            throw std::runtime_error(std::string("Could not create epoll instance: ") + std::strerror(errno));
+    }
+
+    VMScheduler::~VMScheduler() {
+        for(auto& entry: this->tasks)
+            close(entry.first);
+
+        close(this->epfd);
+    }
+
+    void VMScheduler::spawn(int fd) {
+        setNonblocking(fd);
+
+        std::unique_ptr<Task> task = std::make_unique<Task>();
+        task->fd = fd;
+        task->vm = std::make_unique<VirtualMachine>(this->vmparams);
+        task->vm->init();
+        task->vm->setData(this->data);
+
+        task->vm->getIO().port(ULANG_IO_PORT_STDIN).setBackend(std::make_unique<IOFdBackend>(fd));
+        task->vm->getIO().port(ULANG_IO_PORT_STDOUT).setBackend(std::make_unique<IOFdBackend>(fd));
+
+        // registered disarmed, dispatch() arms it for the direction the context waits for
+        epoll_event ev {};
+        ev.events = EPOLLONESHOT;
+        ev.data.fd = fd;
+        if(epoll_ctl(this->epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+            throw std::runtime_error(std::string("epoll_ctl failed: ") + std::strerror(errno));
+
+        Task* raw = task.get();
+        this->tasks.emplace(fd, std::move(task));
+
+        ExecStatus status;
+        try {
+            status = raw->vm->start(this->program);
+        } catch(std::exception& e) {
+            std::cerr << "SCHED: fd " << fd << ": " << e.what() << std::endl;
+            status = ExecStatus::HALTED;
+        }
+
+        this->dispatch(raw, status);
+    }
+
+    void VMScheduler::dispatch(Task* task, ExecStatus status) {
+        if(status == ExecStatus::HALTED) {
+            this->finish(task);
+            return;
+        }
+
+        const IOWait& wait = task->vm->getIOWait();
+        if(wait.port->pollFd() != task->fd) {
+            std::cerr << "SCHED: fd " << task->fd << ": suspended on a port not served by the scheduler" << std::endl;
+            this->finish(task);
+            return;
+        }
+
+        epoll_event ev {};
+        ev.events = (wait.output ? EPOLLOUT : EPOLLIN) | EPOLLONESHOT;
+        ev.data.fd = task->fd;
+        if(epoll_ctl(this->epfd, EPOLL_CTL_MOD, task->fd, &ev) < 0) {
+            std::cerr << "SCHED: fd " << task->fd << ": epoll_ctl failed: " << std::strerror(errno) << std::endl;
+            this->finish(task);
+        }
+    }
+
+    void VMScheduler::finish(Task* task) {
+        int fd = task->fd;
+
+        epoll_ctl(this->epfd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+
+        this->tasks.erase(fd);
+
+        if(this->vmparams.verbose_en)
+            std::cout << "SCHED: fd " << fd << " done, active contexts: " << this->tasks.size() << std::endl;
+    }
+
+    void VMScheduler::serve(int listen_fd) {
+        setNonblocking(listen_fd);
+
+        epoll_event ev {};
+        ev.events = EPOLLIN;
+        ev.data.fd = listen_fd;
+        if(epoll_ctl(this->epfd, EPOLL_CTL_ADD, listen_fd, &ev) < 0)
+            throw std::runtime_error(std::string("epoll_ctl failed: ") + std::strerror(errno));
+
+        epoll_event events[SCHED_EVENTS_MAX];
+
+        while(!sched_stop) {
+            int n = epoll_wait(this->epfd, events, SCHED_EVENTS_MAX, -1);
+            if(n < 0) {
+                if(errno == EINTR)
+                    continue;
+
+                throw std::runtime_error(std::string("epoll_wait failed: ") + std::strerror(errno));
+            }
+
+            for(int i = 0; i < n; i++) {
+                int fd = events[i].data.fd;
+
+                if(fd == listen_fd) {
+                    int conn;
+                    while((conn = accept(listen_fd, nullptr, nullptr)) >= 0) {
+                        try {
+                            this->spawn(conn);
+                        } catch(std::exception& e) {
+                            std::cerr << "SCHED: could not start context: " << e.what() << std::endl;
+                            if(!this->tasks.count(conn))
+                                close(conn);
+                        }
+                    }
+
+                    continue;
+                }
+
+                auto it = this->tasks.find(fd);
+                if(it == this->tasks.end())
+                    continue;
+
+                Task* task = it->second.get();
+
+                ExecStatus status;
+                try {
+                    status = task->vm->resume(this->program);
+                } catch(std::exception& e) {
+                    std::cerr << "SCHED: fd " << fd << ": " << e.what() << std::endl;
+                    status = ExecStatus::HALTED;
+                }
+
+                this->dispatch(task, status);
+            }
+        }
+    }
+
+    void asyncServer(const std::vector<Instruction>& program, const ProgramData& data, const VMParams& vmparams) {
+        int sock = ioListenUnix(vmparams.asyncServerSocket);
+
+        // no SA_RESTART: epoll_wait() has to be interrupted to notice the stop request
+        struct sigaction sa {};
+        sa.sa_handler = sched_onSignal;
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGINT, &sa, nullptr);
+        sigaction(SIGTERM, &sa, nullptr);
+
+        // a vanished client must fail the write, not kill the server
+        signal(SIGPIPE, SIG_IGN);
+
+        if(vmparams.verbose_en)
+            std::cout << "SCHED: listening on " << vmparams.asyncServerSocket << std::endl;
+
+        try {
+            VMScheduler scheduler(program, data, vmparams);
+            scheduler.serve(sock);
+        } catch(...) {
+            close(sock);
+            unlink(vmparams.asyncServerSocket.c_str());
+            throw;
+        }
+
+        close(sock);
+        unlink(vmparams.asyncServerSocket.c_str());
+
+        if(vmparams.verbose_en)
+            std::cout << "SCHED: stopped" << std::endl;
+    }
+};
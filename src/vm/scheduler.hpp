@@ -0,0 +1,70 @@
+#ifndef __ULANG_SCHEDULER_H
+#define __ULANG_SCHEDULER_H
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "bytecode.hpp"
+#include "vm/VirtualMachine.hpp"
+#include "vm/vmparams.hpp"
+
+namespace ULang {
+    /**
+     * @brief Runs many VM contexts on a single thread, multiplexing their I/O with epoll.
+     *
+     * Every context has its stdin/stdout ports on a non-blocking connection. When a port
+     * would block, the context is suspended (see VirtualMachine::resume()) and picked up
+     * again once epoll reports the connection ready.
+     */
+    class VMScheduler {
+        private:
+        struct Task {
+            std::unique_ptr<VirtualMachine> vm;
+            int fd;
+        };
+
+        const std::vector<Instruction>& program;
+        ProgramData data;
+        VMParams vmparams;
+
+        int epfd = -1;
+        std::unordered_map<int, std::unique_ptr<Task>> tasks;  ///< tasks by connection fd
+
+        /**
+         * @brief Creates and starts a VM context served over the connection
+         * @param fd connection
+         */
+        void spawn(int fd);
+
+        /**
+         * @brief Waits for the I/O of a suspended task or finishes a halted one
+         */
+        void dispatch(Task* task, ExecStatus status);
+
+        void finish(Task* task);
+
+        public:
+        /**
+         * @exception std::runtime_error if epoll instance can't be created
+         */
+        VMScheduler(const std::vector<Instruction>& program, const ProgramData& data, const VMParams& vmparams);
+        ~VMScheduler();
+
+        /**
+         * @brief Accepts connections on the listening socket and serves them until SIGINT/SIGTERM
+         * @exception std::runtime_error
+         * @param listen_fd listening socket
+         */
+        void serve(int listen_fd);
+
+        size_t active() const {return this->tasks.size();};
+    };
+
+    /**
+     * @brief Serves the program over UNIX socket (VMParams::asyncServerSocket), one VM context per connection, all on one thread
+     * @exception std::runtime_error
+     */
+    void asyncServer(const std::vector<Instruction>& program, const ProgramData& data, const VMParams& vmparams);
+};
+
+#endif
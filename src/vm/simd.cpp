@@ -0,0 +1,342 @@
+#include "simd.hpp"
+#include <cstring>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define ULANG_SIMD_X86
+#endif
+
+using namespace ULang;
+
+// ==================================================================
+// ======== SCALAR (portable fallback)
+// ==================================================================
+
+template<typename T>
+static inline T lane(const uint8_t* p) {
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    return v;
+}
+
+template<VecBinop OP, typename T>
+static void scalarBinop(uint8_t* dst, const uint8_t* src, size_t n) {
+    for(size_t i = 0; i < n; i += sizeof(T)) {
+        T a = lane<T>(dst + i);
+        T b = lane<T>(src + i);
+        T r;
+
+        // computed in 64 bits, narrow lanes must wrap instead of overflowing after promotion
+        if constexpr(OP == VecBinop::ADD)   r = static_cast<T>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+        if constexpr(OP == VecBinop::SUB)   r = static_cast<T>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b));
+        if constexpr(OP == VecBinop::MUL)   r = static_cast<T>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b));
+        if constexpr(OP == VecBinop::MIN)   r = a < b ? a : b;
+        if constexpr(OP == VecBinop::MAX)   r = a > b ? a : b;
+        if constexpr(OP == VecBinop::CMPEQ) r = a == b ? static_cast<T>(-1) : 0;
+        if constexpr(OP == VecBinop::CMPGT) r = a > b  ? static_cast<T>(-1) : 0;
+
+        std::memcpy(dst + i, &r, sizeof(T));
+    }
+}
+
+template<VecReduce OP, typename T>
+static uint64_t scalarReduce(const uint8_t* src, size_t n) {
+    using Acc = std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>;
+
+    Acc acc = (OP == VecReduce::SUM) ? 0 : lane<T>(src);
+    for(size_t i = 0; i < n; i += sizeof(T)) {
+        Acc v = lane<T>(src + i);
+
+        if constexpr(OP == VecReduce::SUM) acc = static_cast<Acc>(static_cast<uint64_t>(acc) + static_cast<uint64_t>(v));
+        if constexpr(OP == VecReduce::MIN) acc = v < acc ? v : acc;
+        if constexpr(OP == VecReduce::MAX) acc = v > acc ? v : acc;
+    }
+
+    return static_cast<uint64_t>(acc);
+}
+
+template<VecBinop OP, typename U, typename S>
+static void setScalarBinop(SimdKernels& k, unsigned sew) {
+    k.binop[static_cast<int>(OP)][sew][0] = scalarBinop<OP, U>;
+    k.binop[static_cast<int>(OP)][sew][1] = scalarBinop<OP, S>;
+}
+
+template<VecReduce OP, typename U, typename S>
+static void setScalarReduce(SimdKernels& k, unsigned sew) {
+    k.reduce[static_cast<int>(OP)][sew][0] = scalarReduce<OP, U>;
+    k.reduce[static_cast<int>(OP)][sew][1] = scalarReduce<OP, S>;
+}
+
+template<typename U, typename S>
+static void setScalarWidth(SimdKernels& k, unsigned sew) {
+    setScalarBinop<VecBinop::ADD, U, S>(k, sew);
+    setScalarBinop<VecBinop::SUB, U, S>(k, sew);
+    setScalarBinop<VecBinop::MUL, U, S>(k, sew);
+    setScalarBinop<VecBinop::MIN, U, S>(k, sew);
+    setScalarBinop<VecBinop::MAX, U, S>(k, sew);
+    setScalarBinop<VecBinop::CMPEQ, U, S>(k, sew);
+    setScalarBinop<VecBinop::CMPGT, U, S>(k, sew);
+
+    setScalarReduce<VecReduce::SUM, U, S>(k, sew);
+    setScalarReduce<VecReduce::MIN, U, S>(k, sew);
+    setScalarReduce<VecReduce::MAX, U, S>(k, sew);
+}
+
+#define SET_BINOP(K, OP, SEW, SGN, FN) (K).binop[static_cast<int>(VecBinop::OP)][SEW][SGN] = FN
+#define SET_BINOP_BOTH(K, OP, SEW, FN) SET_BINOP(K, OP, SEW, 0, FN); SET_BINOP(K, OP, SEW, 1, FN)
+
+// sign bit of every lane, XOR-ing it in maps unsigned order onto signed order
+#define BIAS8   0x8080808080808080ULL
+#define BIAS16  0x8000800080008000ULL
+#define BIAS32  0x8000000080000000ULL
+#define BIAS64  0x8000000000000000ULL
+
+// ==================================================================
+// ======== SSE2
+// ==================================================================
+
+#if defined(ULANG_SIMD_X86) && defined(__SSE2__)
+
+#define SSE2_KERNEL(NAME, OP)                                                           \
+    static void NAME(uint8_t* dst, const uint8_t* src, size_t n) {                      \
+        for(size_t i = 0; i < n; i += 16) {                                             \
+            __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(dst + i));      \
+            __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(src + i));      \
+            _mm_store_si128(reinterpret_cast<__m128i*>(dst + i), _mm_##OP(a, b));       \
+        }                                                                               \
+    }
+
+#define SSE2_KERNEL_UGT(NAME, CMP, BIAS)                                                \
+    static void NAME(uint8_t* dst, const uint8_t* src, size_t n) {                      \
+        const __m128i bias = _mm_set1_epi64x(static_cast<long long>(BIAS));             \
+        for(size_t i = 0; i < n; i += 16) {                                             \
+            __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(dst + i));      \
+            __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(src + i));      \
+            a = _mm_xor_si128(a, bias);                                                 \
+            b = _mm_xor_si128(b, bias);                                                 \
+            _mm_store_si128(reinterpret_cast<__m128i*>(dst + i), _mm_##CMP(a, b));      \
+        }                                                                               \
+    }
+
+SSE2_KERNEL(sse2_add8,   add_epi8)
+SSE2_KERNEL(sse2_add16,  add_epi16)
+SSE2_KERNEL(sse2_add32,  add_epi32)
+SSE2_KERNEL(sse2_add64,  add_epi64)
+SSE2_KERNEL(sse2_sub8,   sub_epi8)
+SSE2_KERNEL(sse2_sub16,  sub_epi16)
+SSE2_KERNEL(sse2_sub32,  sub_epi32)
+SSE2_KERNEL(sse2_sub64,  sub_epi64)
+SSE2_KERNEL(sse2_mul16,  mullo_epi16)
+SSE2_KERNEL(sse2_minu8,  min_epu8)
+SSE2_KERNEL(sse2_maxu8,  max_epu8)
+SSE2_KERNEL(sse2_mins16, min_epi16)
+SSE2_KERNEL(sse2_maxs16, max_epi16)
+SSE2_KERNEL(sse2_eq8,    cmpeq_epi8)
+SSE2_KERNEL(sse2_eq16,   cmpeq_epi16)
+SSE2_KERNEL(sse2_eq32,   cmpeq_epi32)
+SSE2_KERNEL(sse2_gts8,   cmpgt_epi8)
+SSE2_KERNEL(sse2_gts16,  cmpgt_epi16)
+SSE2_KERNEL(sse2_gts32,  cmpgt_epi32)
+SSE2_KERNEL_UGT(sse2_gtu8,  cmpgt_epi8,  BIAS8)
+SSE2_KERNEL_UGT(sse2_gtu16, cmpgt_epi16, BIAS16)
+SSE2_KERNEL_UGT(sse2_gtu32, cmpgt_epi32, BIAS32)
+
+// SSE2 has no 32/64-bit multiply, 64-bit compares and most of the min/max, those stay scalar
+static void setSSE2(SimdKernels& k) {
+    SET_BINOP_BOTH(k, ADD, 0, sse2_add8);
+    SET_BINOP_BOTH(k, ADD, 1, sse2_add16);
+    SET_BINOP_BOTH(k, ADD, 2, sse2_add32);
+    SET_BINOP_BOTH(k, ADD, 3, sse2_add64);
+    SET_BINOP_BOTH(k, SUB, 0, sse2_sub8);
+    SET_BINOP_BOTH(k, SUB, 1, sse2_sub16);
+    SET_BINOP_BOTH(k, SUB, 2, sse2_sub32);
+    SET_BINOP_BOTH(k, SUB, 3, sse2_sub64);
+    SET_BINOP_BOTH(k, MUL, 1, sse2_mul16);
+
+    SET_BINOP(k, MIN, 0, 0, sse2_minu8);
+    SET_BINOP(k, MAX, 0, 0, sse2_maxu8);
+    SET_BINOP(k, MIN, 1, 1, sse2_mins16);
+    SET_BINOP(k, MAX, 1, 1, sse2_maxs16);
+
+    SET_BINOP_BOTH(k, CMPEQ, 0, sse2_eq8);
+    SET_BINOP_BOTH(k, CMPEQ, 1, sse2_eq16);
+    SET_BINOP_BOTH(k, CMPEQ, 2, sse2_eq32);
+
+    SET_BINOP(k, CMPGT, 0, 0, sse2_gtu8);
+    SET_BINOP(k, CMPGT, 1, 0, sse2_gtu16);
+    SET_BINOP(k, CMPGT, 2, 0, sse2_gtu32);
+    SET_BINOP(k, CMPGT, 0, 1, sse2_gts8);
+    SET_BINOP(k, CMPGT, 1, 1, sse2_gts16);
+    SET_BINOP(k, CMPGT, 2, 1, sse2_gts32);
+
+    k.isa = "sse2";
+}
+
+#endif
+
+// ==================================================================
+// ======== AVX2 (compiled for the target on demand, picked at runtime)
+// ==================================================================
+
+#if defined(ULANG_SIMD_X86) && defined(__GNUC__)
+
+#define ULANG_SIMD_AVX2
+
+#define AVX2_KERNEL(NAME, OP)                                                               \
+    __attribute__((target("avx2")))                                                         \
+    static void NAME(uint8_t* dst, const uint8_t* src, size_t n) {                          \
+        size_t i = 0;                                                                       \
+        for(; i + 32 <= n; i += 32) {                                                       \
+            __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(dst + i));       \
+            __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(src + i));       \
+            _mm256_store_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_##OP(a, b));     \
+        }                                                                                   \
+        for(; i < n; i += 16) {                                                             \
+            __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(dst + i));          \
+            __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(src + i));          \
+            _mm_store_si128(reinterpret_cast<__m128i*>(dst + i), _mm_##OP(a, b));           \
+        }                                                                                   \
+    }
+
+#define AVX2_KERNEL_UGT(NAME, CMP, BIAS)                                                    \
+    __attribute__((target("avx2")))                                                         \
+    static void NAME(uint8_t* dst, const uint8_t* src, size_t n) {                          \
+        size_t i = 0;                                                                       \
+        for(; i + 32 <= n; i += 32) {                                                       \
+            const __m256i bias = _mm256_set1_epi64x(static_cast<long long>(BIAS));          \
+            __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(dst + i));       \
+            __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(src + i));       \
+            a = _mm256_xor_si256(a, bias);                                                  \
+            b = _mm256_xor_si256(b, bias);                                                  \
+            _mm256_store_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_##CMP(a, b));    \
+        }                                                                                   \
+        for(; i < n; i += 16) {                                                             \
+            const __m128i bias = _mm_set1_epi64x(static_cast<long long>(BIAS));             \
+            __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(dst + i));          \
+            __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(src + i));          \
+            a = _mm_xor_si128(a, bias);                                                     \
+            b = _mm_xor_si128(b, bias);                                                     \
+            _mm_store_si128(reinterpret_cast<__m128i*>(dst + i), _mm_##CMP(a, b));          \
+        }                                                                                   \
+    }
+
+AVX2_KERNEL(avx2_add8,   add_epi8)
+AVX2_KERNEL(avx2_add16,  add_epi16)
+AVX2_KERNEL(avx2_add32,  add_epi32)
+AVX2_KERNEL(avx2_add64,  add_epi64)
+AVX2_KERNEL(avx2_sub8,   sub_epi8)
+AVX2_KERNEL(avx2_sub16,  sub_epi16)
+AVX2_KERNEL(avx2_sub32,  sub_epi32)
+AVX2_KERNEL(avx2_sub64,  sub_epi64)
+AVX2_KERNEL(avx2_mul16,  mullo_epi16)
+AVX2_KERNEL(avx2_mul32,  mullo_epi32)
+AVX2_KERNEL(avx2_minu8,  min_epu8)
+AVX2_KERNEL(avx2_minu16, min_epu16)
+AVX2_KERNEL(avx2_minu32, min_epu32)
+AVX2_KERNEL(avx2_mins8,  min_epi8)
+AVX2_KERNEL(avx2_mins16, min_epi16)
+AVX2_KERNEL(avx2_mins32, min_epi32)
+AVX2_KERNEL(avx2_maxu8,  max_epu8)
+AVX2_KERNEL(avx2_maxu16, max_epu16)
+AVX2_KERNEL(avx2_maxu32, max_epu32)
+AVX2_KERNEL(avx2_maxs8,  max_epi8)
+AVX2_KERNEL(avx2_maxs16, max_epi16)
+AVX2_KERNEL(avx2_maxs32, max_epi32)
+AVX2_KERNEL(avx2_eq8,    cmpeq_epi8)
+AVX2_KERNEL(avx2_eq16,   cmpeq_epi16)
+AVX2_KERNEL(avx2_eq32,   cmpeq_epi32)
+AVX2_KERNEL(avx2_eq64,   cmpeq_epi64)
+AVX2_KERNEL(avx2_gts8,   cmpgt_epi8)
+AVX2_KERNEL(avx2_gts16,  cmpgt_epi16)
+AVX2_KERNEL(avx2_gts32,  cmpgt_epi32)
+AVX2_KERNEL(avx2_gts64,  cmpgt_epi64)
+AVX2_KERNEL_UGT(avx2_gtu8,  cmpgt_epi8,  BIAS8)
+AVX2_KERNEL_UGT(avx2_gtu16, cmpgt_epi16, BIAS16)
+AVX2_KERNEL_UGT(avx2_gtu32, cmpgt_epi32, BIAS32)
+AVX2_KERNEL_UGT(avx2_gtu64, cmpgt_epi64, BIAS64)
+
+// no 64-bit multiply and min/max before AVX-512, those stay scalar
+static void setAVX2(SimdKernels& k) {
+    SET_BINOP_BOTH(k, ADD, 0, avx2_add8);
+    SET_BINOP_BOTH(k, ADD, 1, avx2_add16);
+    SET_BINOP_BOTH(k, ADD, 2, avx2_add32);
+    SET_BINOP_BOTH(k, ADD, 3, avx2_add64);
+    SET_BINOP_BOTH(k, SUB, 0, avx2_sub8);
+    SET_BINOP_BOTH(k, SUB, 1, avx2_sub16);
+    SET_BINOP_BOTH(k, SUB, 2, avx2_sub32);
+    SET_BINOP_BOTH(k, SUB, 3, avx2_sub64);
+    SET_BINOP_BOTH(k, MUL, 1, avx2_mul16);
+    SET_BINOP_BOTH(k, MUL, 2, avx2_mul32);
+
+    SET_BINOP(k, MIN, 0, 0, avx2_minu8);
+    SET_BINOP(k, MIN, 1, 0, avx2_minu16);
+    SET_BINOP(k, MIN, 2, 0, avx2_minu32);
+    SET_BINOP(k, MIN, 0, 1, avx2_mins8);
+    SET_BINOP(k, MIN, 1, 1, avx2_mins16);
+    SET_BINOP(k, MIN, 2, 1, avx2_mins32);
+    SET_BINOP(k, MAX, 0, 0, avx2_maxu8);
+    SET_BINOP(k, MAX, 1, 0, avx2_maxu16);
+    SET_BINOP(k, MAX, 2, 0, avx2_maxu32);
+    SET_BINOP(k, MAX, 0, 1, avx2_maxs8);
+    SET_BINOP(k, MAX, 1, 1, avx2_maxs16);
+    SET_BINOP(k, MAX, 2, 1, avx2_maxs32);
+
+    SET_BINOP_BOTH(k, CMPEQ, 0, avx2_eq8);
+    SET_BINOP_BOTH(k, CMPEQ, 1, avx2_eq16);
+    SET_BINOP_BOTH(k, CMPEQ, 2, avx2_eq32);
+    SET_BINOP_BOTH(k, CMPEQ, 3, avx2_eq64);
+
+    SET_BINOP(k, CMPGT, 0, 0, avx2_gtu8);
+    SET_BINOP(k, CMPGT, 1, 0, avx2_gtu16);
+    SET_BINOP(k, CMPGT, 2, 0, avx2_gtu32);
+    SET_BINOP(k, CMPGT, 3, 0, avx2_gtu64);
+    SET_BINOP(k, CMPGT, 0, 1, avx2_gts8);
+    SET_BINOP(k, CMPGT, 1, 1, avx2_gts16);
+    SET_BINOP(k, CMPGT, 2, 1, avx2_gts32);
+    SET_BINOP(k, CMPGT, 3, 1, avx2_gts64);
+
+    k.isa = "avx2";
+}
+
+#endif
+
+// ==================================================================
+// ======== DISPATCH
+// ==================================================================
+
+static SimdKernels buildKernels() {
+    SimdKernels k {};
+
+    setScalarWidth<uint8_t,  int8_t >(k, 0);
+    setScalarWidth<uint16_t, int16_t>(k, 1);
+    setScalarWidth<uint32_t, int32_t>(k, 2);
+    setScalarWidth<uint64_t, int64_t>(k, 3);
+    k.isa = "scalar";
+
+#if defined(ULANG_SIMD_X86) && defined(__SSE2__)
+    setSSE2(k);
+#endif
+
+#ifdef ULANG_SIMD_AVX2
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        setAVX2(k);
+#endif
+
+    return k;
+}
+
+namespace ULang {
+    const SimdKernels& simdKernels() {
+        static const SimdKernels kernels = buildKernels();
+        return kernels;
+    }
+
+    void simdBroadcast(uint8_t* dst, uint64_t val, unsigned sew, size_t n) {
+        size_t lane_sz = size_t(1) << sew;
+
+        for(size_t i = 0; i < n; i += lane_sz)
+            std::memcpy(dst + i, &val, lane_sz); // little-endian, low bytes first
+    }
+};
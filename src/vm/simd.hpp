@@ -0,0 +1,73 @@
+#ifndef __ULANG_SIMD_H
+#define __ULANG_SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+#define ULANG_VREG_COUNT    16
+#define ULANG_VREG_SIZE     32      ///< bytes, enough for the 256-bit vector length
+
+// VTYPE register layout
+#define ULANG_VTYPE_SEW_MASK    0x3     ///< lane width: 0 = 8, 1 = 16, 2 = 32, 3 = 64 bits
+#define ULANG_VTYPE_SIGNED      0x4     ///< lanes are signed (MIN/MAX/CMPGT and reductions)
+#define ULANG_VTYPE_VL256       0x8     ///< operate on 256 bits, 128 bits otherwise
+
+namespace ULang {
+    /**
+     * @brief Vector register
+     */
+    struct alignas(ULANG_VREG_SIZE) VReg {
+        uint8_t b[ULANG_VREG_SIZE];
+    };
+
+    enum class VecBinop {
+        ADD,
+        SUB,
+        MUL,    ///< low half of the product
+        MIN,
+        MAX,
+        CMPEQ,  ///< all-ones lane if equal, zero otherwise
+        CMPGT,  ///< all-ones lane if greater, zero otherwise
+        COUNT
+    };
+
+    enum class VecReduce {
+        SUM,    ///< accumulated in 64 bits
+        MIN,
+        MAX,
+        COUNT
+    };
+
+    /**
+     * @brief Lane-wise kernel, dst = dst OP src over n bytes (n is a multiple of 16, both 16-byte aligned)
+     */
+    using VecBinopFn = void (*)(uint8_t* dst, const uint8_t* src, size_t n);
+
+    /**
+     * @brief Horizontal kernel over n bytes, signed results are sign-extended
+     */
+    using VecReduceFn = uint64_t (*)(const uint8_t* src, size_t n);
+
+    /**
+     * @brief Vector kernels for every operation, lane width and signedness
+     */
+    struct SimdKernels {
+        const char* isa;    ///< instruction set the table was built for
+
+        VecBinopFn binop[static_cast<int>(VecBinop::COUNT)][4][2];
+        VecReduceFn reduce[static_cast<int>(VecReduce::COUNT)][4][2];
+    };
+
+    /**
+     * @brief Returns the kernel table for the best instruction set the host CPU supports (scalar, SSE2 or AVX2)
+     */
+    const SimdKernels& simdKernels();
+
+    /**
+     * @brief Fills the lanes of n bytes with the low bits of val
+     * @param sew lane width (ULANG_VTYPE_SEW_MASK field)
+     */
+    void simdBroadcast(uint8_t* dst, uint64_t val, unsigned sew, size_t n);
+};
+
+#endif
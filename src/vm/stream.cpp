@@ -0,0 +1,145 @@
+#include "stream.hpp"
+#include "loader.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+namespace ULang {
+    ProgramStream::~ProgramStream() {
+        if(this->reader.joinable())
+            this->reader.join();
+    }
+
+    void ProgramStream::readSome(size_t upto) {
+        size_t n = std::min<size_t>(upto - this->received, ULANG_STREAM_CHUNK);
+
+        for(;;) {
+            ssize_t res = ::read(this->fd, this->buf.data() + this->received, n);
+            if(res < 0) {
+                if(errno == EINTR)
+                    continue;
+
+                throw std::runtime_error(std::string("Bytecode read failed: ") + std::strerror(errno));
+            }
+
+            if(res == 0)
+                throw std::runtime_error("Bytecode truncated: input ended at offset " + std::to_string(this->received));
+
+            this->received += res;
+            return;
+        }
+    }
+
+    void ProgramStream::readUpto(size_t upto) {
+        while(this->received < upto)
+            this->readSome(upto);
+    }
+
+    void ProgramStream::readHead() {
+        this->buf.resize(sizeof(BytecodeHeader));
+        this->readUpto(sizeof(BytecodeHeader));
+        std::memcpy(&this->hdr, this->buf.data(), sizeof(BytecodeHeader));
+
+        // the image size is only known from the header, input past it belongs to the program
+        size_t total = std::max({
+            size_t(sizeof(BytecodeHeader)),
+            size_t(this->hdr.code_offset) + this->hdr.code_size,
+            size_t(this->hdr.data_offset) + this->hdr.data_size,
+            size_t(this->hdr.meta_offset) + this->hdr.meta_size
+        });
+
+        if(!validateHeader(this->hdr, total))
+            throw std::runtime_error("Invalid header");
+
+        this->buf.resize(total);
+        this->readUpto(std::min<size_t>(this->hdr.code_offset, total));
+    }
+
+    bool ProgramStream::streamable() const {
+        // compressed sections are only decoded once unpackSections() has the whole file
+        if(this->hdr.flags & (BC_FLAG_COMPACT | BC_FLAG_COMPRESSED))
+            return false;
+
+        if(this->hdr.code_size % Instruction{}.calcTotalSz() != 0)
+            return false;
+
+        return this->hdr.data_size == 0 || this->hdr.data_offset + this->hdr.data_size <= this->hdr.code_offset;
+    }
+
+    void ProgramStream::readAll() {
+        this->readUpto(this->buf.size());
+    }
+
+    void ProgramStream::start(std::vector<Instruction>& program) {
+        program.assign(this->hdr.code_size / Instruction{}.calcTotalSz(), Instruction{});
+        this->reader = std::thread(&ProgramStream::readerMain, this, &program);
+    }
+
+    void ProgramStream::readerMain(std::vector<Instruction>* program) {
+        const size_t instr_size = Instruction{}.calcTotalSz();
+        size_t code_end = this->hdr.code_offset + this->hdr.code_size;
+        size_t next = 0;
+
+        try {
+            while(next < program->size()) {
+                this->readSome(code_end);
+
+                size_t complete = (this->received - this->hdr.code_offset) / instr_size;
+                if(complete == next)
+                    continue;
+
+                decodeProgramRange(this->buf, this->hdr, *program, next, complete);
+                next = complete;
+
+                {
+                    std::lock_guard<std::mutex> guard(this->lock);
+                    this->decoded = next;
+                }
+                this->cv.notify_all();
+            }
+
+            this->readUpto(this->buf.size());
+            verifyChecksum(this->buf, this->hdr);
+        } catch(...) {
+            std::lock_guard<std::mutex> guard(this->lock);
+            this->error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(this->lock);
+            this->done = true;
+        }
+        this->cv.notify_all();
+    }
+
+    size_t ProgramStream::waitFor(size_t index) {
+        std::unique_lock<std::mutex> guard(this->lock);
+        this->cv.wait(guard, [&]() {return this->decoded > index || this->done;});
+
+        if(this->decoded <= index && this->error)
+            std::rethrow_exception(this->error);
+
+        return this->decoded;
+    }
+
+    void ProgramStream::finish() {
+        {
+            std::unique_lock<std::mutex> guard(this->lock);
+            this->cv.wait(guard, [&]() {return this->done;});
+        }
+
+        if(this->reader.joinable())
+            this->reader.join();
+
+        if(this->error)
+            std::rethrow_exception(this->error);
+    }
+
+    size_t IOStreamTailBackend::read(uint8_t* buf, size_t n) {
+        this->stream.finish();
+        return this->backend->read(buf, n);
+    }
+};
@@ -0,0 +1,119 @@
+#ifndef __ULANG_STREAM_H
+#define __ULANG_STREAM_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "bytecode.hpp"
+#include "vm/io.hpp"
+
+#define ULANG_STREAM_CHUNK (64 * 1024)     ///< bytes read from the pipe at once
+
+namespace ULang {
+    /**
+     * @brief Loads a bytecode image from a pipe while the program already runs.
+     *
+     * The header and the data section (which the compiler places in front of the code) are read
+     * up front. A background thread then reads the code, decoding every instruction as soon as it
+     * is complete, and the interpreter only blocks when it reaches code that has not arrived yet.
+     * The checksum covers the whole file, so it is verified once the image is complete.
+     */
+    class ProgramStream {
+        private:
+        int fd;
+        std::vector<uint8_t> buf;       ///< whole image, allocated from the header so it never moves
+        BytecodeHeader hdr {};
+        size_t received = 0;            ///< bytes of buf read so far
+
+        std::thread reader;
+        std::mutex lock;
+        std::condition_variable cv;
+        size_t decoded = 0;             ///< instructions ready, guarded by lock
+        bool done = false;              ///< image complete (or failed), guarded by lock
+        std::exception_ptr error;       ///< reader failure, guarded by lock
+
+        /**
+         * @brief Does a single read into buf, of at most ULANG_STREAM_CHUNK bytes and not past upto
+         * @exception std::runtime_error on read error or premature end of input
+         */
+        void readSome(size_t upto);
+
+        /**
+         * @brief Reads buf up to offset upto
+         * @exception std::runtime_error on read error or premature end of input
+         */
+        void readUpto(size_t upto);
+
+        void readerMain(std::vector<Instruction>* program);
+
+        public:
+        ProgramStream(int fd): fd(fd) {};
+
+        /**
+         * @brief Waits for the background reader, which only stops at the end of the image
+         */
+        ~ProgramStream();
+
+        /**
+         * @brief Reads and validates the header, then reads everything in front of the code section
+         * @exception std::runtime_error on read error or invalid header
+         */
+        void readHead();
+
+        /**
+         * @brief Whether the image can run while it is being read: fixed-size, uncompressed code with the data section in front of it
+         */
+        bool streamable() const;
+
+        /**
+         * @brief Reads the rest of the image on the calling thread
+         * @exception std::runtime_error on read error or premature end of input
+         */
+        void readAll();
+
+        /**
+         * @brief Starts the background reader, program is sized to the instruction count and filled in as the code arrives
+         * @param program program, must not be resized until finish()
+         */
+        void start(std::vector<Instruction>& program);
+
+        /**
+         * @brief Blocks until the instruction at index is decoded
+         * @exception std::runtime_error if the image turned out to be truncated or corrupted
+         * @return size_t number of instructions decoded, more than index
+         */
+        size_t waitFor(size_t index);
+
+        /**
+         * @brief Blocks until the whole image is read and verified
+         * @exception std::runtime_error if the image turned out to be truncated or corrupted
+         */
+        void finish();
+
+        std::vector<uint8_t>& buffer() {return this->buf;};
+        BytecodeHeader& header() {return this->hdr;};
+    };
+
+    /**
+     * @brief Program input sharing the descriptor with a streamed image, available only once the image is read
+     */
+    class IOStreamTailBackend: public IOBackend {
+        private:
+        ProgramStream& stream;
+        std::unique_ptr<IOBackend> backend;
+
+        public:
+        IOStreamTailBackend(ProgramStream& stream, std::unique_ptr<IOBackend> backend): stream(stream), backend(std::move(backend)) {};
+
+        size_t read(uint8_t* buf, size_t n) override;
+        size_t write(const uint8_t* buf, size_t n) override {return this->backend->write(buf, n);};
+        int pollFd() const override {return this->backend->pollFd();};
+    };
+};
+
+#endif
@@ -1,12 +1,17 @@
 #include "VirtualMachine.hpp"
 #include "bytecode.hpp"
+#include "vm/stream.hpp"
 #include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
 #include <vector>
 
 using namespace ULang;
@@ -53,37 +58,152 @@ namespace ULang {
         }
 
         memset(this->regs, 0x00, sizeof(uint64_t) * this->REG_COUNT);
+        memset(this->vregs, 0x00, sizeof(this->vregs));
+
+        this->simd = &simdKernels();
+        if(this->vmparams.verbose_en)
+            std::cout << "INIT: vector registers: " << ULANG_VREG_COUNT << " x " << ULANG_VREG_SIZE * 8 << " bits, kernels: " << this->simd->isa << std::endl;
+
         this->pc =    &regs[R_PC.reg_no];       // Program counter
         this->sp =    &regs[R_SP.reg_no];       // Stack pointer
         this->fp =    &regs[R_FP.reg_no];       // Frame pointer
         this->flags = &regs[R_FLAGS.reg_no];    // Flags
 
         this->stack = (uint8_t*) malloc(this->STACK_SIZE);
-        *this->sp = reinterpret_cast<uint64_t>(this->stack + this->STACK_SIZE);
+        *this->sp = this->STACK_SIZE;
 
         this->heap_init();
+        this->io_init();
+    }
+
+    void VirtualMachine::io_init() {
+        IOFlushPolicy policy = ioFlushPolicyFromStr(this->vmparams.io_flush);
+        size_t bufsize = this->vmparams.io_bufsize_kb * 1024;
+
+        IOPort& in  = this->io.port(ULANG_IO_PORT_STDIN);
+        IOPort& out = this->io.port(ULANG_IO_PORT_STDOUT);
+        IOPort& err = this->io.port(ULANG_IO_PORT_STDERR);
+
+        if(this->vmparams.io_backend == "fd") {
+            in.setup(std::make_unique<IOFdBackend>(STDIN_FILENO), policy, bufsize);
+            out.setup(std::make_unique<IOFdBackend>(STDOUT_FILENO), policy, bufsize);
+            err.setup(std::make_unique<IOFdBackend>(STDERR_FILENO), IOFlushPolicy::LINE, bufsize);
+        } else if(this->vmparams.io_backend == "stream") {
+            in.setup(std::make_unique<IOStreamBackend>(&std::cin, nullptr), policy, bufsize);
+            out.setup(std::make_unique<IOStreamBackend>(nullptr, &std::cout), policy, bufsize);
+            err.setup(std::make_unique<IOStreamBackend>(nullptr, &std::cerr), IOFlushPolicy::LINE, bufsize);
+        } else {
+            throw std::runtime_error("Unknown I/O backend: " + this->vmparams.io_backend);
+        }
+
+        // prompts have to be visible before blocking on input
+        in.tie(&out);
+
+        if(this->vmparams.verbose_en) {
+            std::cout << "INIT: I/O backend: " << this->vmparams.io_backend << ", flush: " << this->vmparams.io_flush;
+            std::cout << ", buffer size: " << bufsize << std::endl;
+        }
+    }
+
+    void VirtualMachine::halt() {
+        this->running = false;
+
+        IOPort* blocked = this->io.flushAll();
+        if(blocked)
+            this->io_suspend(*blocked, true);
+    }
+
+    void VirtualMachine::io_suspend(IOPort& port, bool output) {
+        this->io_wait.port = &port;
+        this->io_wait.output = output;
+    }
+
+    void VirtualMachine::io_waitReady() {
+        int fd = this->io_wait.port ? this->io_wait.port->pollFd() : -1;
+        if(fd < 0)
+            throw std::runtime_error("Suspended on I/O port which can't be waited for");
+
+        pollfd pfd {fd, static_cast<short>(this->io_wait.output ? POLLOUT : POLLIN), 0};
+        while(poll(&pfd, 1, -1) < 0) {
+            if(errno != EINTR)
+                throw std::runtime_error(std::string("I/O poll failed: ") + std::strerror(errno));
+        }
     }
 
-    void VirtualMachine::run(const std::vector<Instruction> program) {
+    void VirtualMachine::reset() {
+        memset(this->regs, 0x00, sizeof(uint64_t) * this->REG_COUNT);
+        memset(this->vregs, 0x00, sizeof(this->vregs));
+        *this->sp = this->STACK_SIZE;
+
+        this->heap_reset();
+    }
+
+    void VirtualMachine::run(const std::vector<Instruction>& program) {
         if(this->vmparams.verbose_en) {
             std::cout << "EXEC: instruction count: " << program.size() << std::endl;
         }
 
+        ExecStatus status = this->start(program);
+        while(status == ExecStatus::SUSPENDED) {
+            this->io_waitReady();
+            status = this->resume(program);
+        }
+    }
+
+    ExecStatus VirtualMachine::start(const std::vector<Instruction>& program) {
         this->stat_exec_begin = std::chrono::steady_clock::now();
 
-        bool running = true;
+        this->running = true;
         *this->pc = 0;
-        while(running && *this->pc < program.size()) {
-            this->execute(program[*this->pc]);
-            (*this->pc)++;
+
+        return this->resume(program);
+    }
+
+    ExecStatus VirtualMachine::resume(const std::vector<Instruction>& program) {
+        this->io_wait = {};
+
+        try {
+            while(this->running && *this->pc < program.size()) {
+                // code still being streamed in
+                if(*this->pc >= this->code_ready)
+                    this->code_ready = this->stream->waitFor(*this->pc);
+
+                // PC points past the instruction while it runs, branches overwrite it
+                const Instruction& instr = program[(*this->pc)++];
+
+                this->execute(instr);
+                if(this->io_wait.port) {
+                    (*this->pc)--;
+                    return ExecStatus::SUSPENDED;
+                }
+            }
+
+            // also finishes the flush of a HALT suspended on output
+            this->halt();
+        } catch(...) {
+            // keep the output produced before the failure
+            try {
+                (void) this->io.flushAll();
+            } catch(...) {}
+
+            this->running = false;
+            throw;
         }
+
+        return this->io_wait.port ? ExecStatus::SUSPENDED : ExecStatus::HALTED;
     }
 
     uint64_t VirtualMachine::readOpCast(const Operand& op) {
         uint64_t res = 0;
-        switch(op.type) { // TODO: constants
-            case OperandType::OP_CONSTANT:
+        switch(op.type) {
             case OperandType::OP_IMMEDIATE: res = static_cast<uint32_t>(op.data); break;
+            case OperandType::OP_CONSTANT:
+                if(op.data >= this->data.const_count)
+                    throw std::runtime_error("Constant pool index out of bounds");
+
+                res = this->data.constants[op.data];
+                break;
+
             case OperandType::OP_REGISTER:  res = this->regs[op.data]; break;
             case OperandType::OP_REFERENCE: res = *(uint64_t*) this->castHeapReference(op.data); break;
             case OperandType::OP_NULL:      res = 0; break;
@@ -93,7 +213,7 @@ namespace ULang {
 
         if(this->vmparams.verbose_en) {
             std::cout << "\033[35m\t--> ";
-            std::cout << "read: " << fmtOperand(op) << " -> " << static_cast<uint32_t>(res);
+            std::cout << "read: " << fmtOperand(op) << " -> " << res;
             std::cout << "\033[0m" << std::endl;
         }
 
@@ -121,7 +241,69 @@ namespace ULang {
 
         if(this->vmparams.verbose_en) {
             std::cout << "\033[35m\t--> ";
-            std::cout << "write: " << fmtOperand(op) << " <- " << static_cast<uint32_t>(val);
+            std::cout << "write: " << fmtOperand(op) << " <- " << val;
+            std::cout << "\033[0m" << std::endl;
+        }
+    }
+
+    uint8_t* VirtualMachine::castOperandAddress(const Operand& op, uint64_t size) {
+        switch(op.type) {
+            case OperandType::OP_REFERENCE: return this->castHeapReference(op.data, size);
+            case OperandType::OP_REGISTER:  return this->castHeapReference(this->regs[op.data], size);
+
+            default:
+                throw std::runtime_error("Excepted heap reference");
+        }
+    }
+
+    uint64_t VirtualMachine::loadSized(const Operand& op, size_t size, bool sign) {
+        const uint8_t* src = this->castOperandAddress(op, size);
+        uint64_t res;
+
+        switch(size) {
+            case 1: {
+                uint8_t v = *src;
+                res = sign ? static_cast<uint64_t>(static_cast<int64_t>(static_cast<int8_t>(v))) : v;
+                break;
+            }
+
+            case 2: {
+                uint16_t v;
+                memcpy(&v, src, sizeof(v));
+                res = sign ? static_cast<uint64_t>(static_cast<int64_t>(static_cast<int16_t>(v))) : v;
+                break;
+            }
+
+            case 4: {
+                uint32_t v;
+                memcpy(&v, src, sizeof(v));
+                res = sign ? static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(v))) : v;
+                break;
+            }
+
+            default:
+                throw std::runtime_error("Invalid access width");
+        }
+
+        if(this->vmparams.verbose_en) {
+            std::cout << "\033[35m\t--> ";
+            std::cout << "read" << std::dec << size * 8 << (sign ? "s" : "") << ": " << fmtOperand(op) << " -> " << res;
+            std::cout << "\033[0m" << std::endl;
+        }
+
+        return res;
+    }
+
+    void VirtualMachine::storeSized(const Operand& op, size_t size, uint64_t val) {
+        if(size != 1 && size != 2 && size != 4)
+            throw std::runtime_error("Invalid access width");
+
+        // little-endian: the low bytes come first
+        memcpy(this->castOperandAddress(op, size), &val, size);
+
+        if(this->vmparams.verbose_en) {
+            std::cout << "\033[35m\t--> ";
+            std::cout << "write" << std::dec << size * 8 << ": " << fmtOperand(op) << " <- " << val;
             std::cout << "\033[0m" << std::endl;
         }
     }
@@ -132,8 +314,14 @@ namespace ULang {
             std::cout << std::setw(8) << std::setfill('0') << std::hex << instr.offset;
             std::cout << ": " << opcodeToStr(instr.opcode);
 
-            for(const auto& op : instr.operands)
-                std::cout << " " << fmtOperand(op);
+            for(size_t i = 0; i < instr.operands.size(); i++) {
+                const Operand& op = instr.operands[i];
+
+                if(op.type == OperandType::OP_REGISTER && isVectorOperand(instr.opcode, i))
+                    std::cout << " v" << std::dec << op.data;
+                else
+                    std::cout << " " << fmtOperand(op);
+            }
 
             std::cout << std::endl;
         }
@@ -144,30 +332,122 @@ namespace ULang {
             case Opcode::NOP: break;
 
             case Opcode::PUSH: {
-                const Operand& op = instr.operands[0];
-                uint64_t val = 0;
-
-                switch(op.type) {
-                    case OperandType::OP_IMMEDIATE: 
-                        val = op.data; break;
-                    case OperandType::OP_REGISTER:
-                        val = this->regs[op.data]; break;
-                    default:
-                        std::runtime_error("Invalid operand");
-                }
-
-                *this->sp -= sizeof(uint64_t);
-                *(uint64_t*)(this->stack + *this->sp) = val;
+                this->stack_push(this->readOpCast(instr.operands[0]));
                 break;
             }
 
             case Opcode::POP: {
                 const Operand& op = instr.operands[0];
-                uint64_t val = *(uint64_t*)(this->stack + *this->sp);
-                *this->sp += sizeof(uint64_t);
+                uint64_t val = this->stack_pop();
+
+                if(op.type != OperandType::OP_NULL)
+                    this->writeOpCast(op, val);
+
+                break;
+            }
+
+            case Opcode::JMP: {
+                *this->pc = instr.operands[0].data;
+                break;
+            }
+
+            case Opcode::JZ:
+            case Opcode::JNE:
+            case Opcode::JL:
+            case Opcode::JLE:
+            case Opcode::JG:
+            case Opcode::JGE:
+            case Opcode::JB:
+            case Opcode::JBE:
+            case Opcode::JA:
+            case Opcode::JAE: {
+                if(this->condition(instr.opcode))
+                    *this->pc = instr.operands[0].data;
+
+                break;
+            }
+
+            case Opcode::CALL: {
+                //
+                // push PC (return address), PC = [TARGET]
+                //
+
+                this->stack_push(*this->pc);
+                *this->pc = instr.operands[0].data;
+                break;
+            }
+
+            case Opcode::RET: {
+                //
+                // [FNR] = [VAL] (if any), PC = pop
+                //
+
+                if(instr.operands[0].type != OperandType::OP_NULL)
+                    this->regs[R_FNR.reg_no] = this->readOpCast(instr.operands[0]);
+
+                *this->pc = this->stack_pop();
+                break;
+            }
+
+            case Opcode::CMP: {
+                //
+                // FLAGS = flags([A] - [B])
+                //
+
+                uint64_t a = this->readOpCast(instr.operands[0]);
+                uint64_t b = this->readOpCast(instr.operands[1]);
+                uint64_t res = a - b;
+
+                uint64_t f = 0;
+                if(res == 0)                    f |= ULANG_FLAG_ZF;
+                if(res >> 63)                   f |= ULANG_FLAG_SF;
+                if(a < b)                       f |= ULANG_FLAG_CF;
+                if(((a ^ b) & (a ^ res)) >> 63) f |= ULANG_FLAG_OF;
+
+                *this->flags = f;
+                break;
+            }
+
+            case Opcode::TEST: {
+                //
+                // FLAGS = flags([A] & [B])
+                //
 
-                if(op.type == OperandType::OP_REGISTER)
-                    this->regs[op.data] = val;
+                uint64_t res = this->readOpCast(instr.operands[0]) & this->readOpCast(instr.operands[1]);
+
+                uint64_t f = 0;
+                if(res == 0)    f |= ULANG_FLAG_ZF;
+                if(res >> 63)   f |= ULANG_FLAG_SF;
+
+                *this->flags = f;
+                break;
+            }
+
+            case Opcode::BEQZ:
+            case Opcode::BNEZ:
+            case Opcode::BLTZ:
+            case Opcode::BGEZ:
+            case Opcode::BGTZ:
+            case Opcode::BLEZ: {
+                //
+                // if([VAL] <cond> 0) PC = [TARGET], FLAGS untouched
+                //
+
+                int64_t val = static_cast<int64_t>(this->readOpCast(instr.operands[0]));
+                bool taken = false;
+
+                switch(instr.opcode) {
+                    case Opcode::BEQZ: taken = val == 0; break;
+                    case Opcode::BNEZ: taken = val != 0; break;
+                    case Opcode::BLTZ: taken = val < 0;  break;
+                    case Opcode::BGEZ: taken = val >= 0; break;
+                    case Opcode::BGTZ: taken = val > 0;  break;
+                    case Opcode::BLEZ: taken = val <= 0; break;
+                    default: break;
+                }
+
+                if(taken)
+                    *this->pc = instr.operands[1].data;
 
                 break;
             }
@@ -241,8 +521,113 @@ namespace ULang {
                 uint64_t q = a / b;
                 uint64_t r = a % b;
 
-                writeOpCast(dst, q);
+                // remainder first, the quotient wins when DST is TMP0
                 this->regs[R_TMP0.reg_no] = r;
+                writeOpCast(dst, q);
+
+                break;
+            }
+
+            case Opcode::IDIV: {
+                //
+                // [DST]  = ([DST] / [SRC]), signed
+                // [TMP0] = ([DST] % [SRC]), signed
+                //
+
+                const Operand& dst = instr.operands[0];
+                const Operand& src = instr.operands[1];
+
+                int64_t a = static_cast<int64_t>(readOpCast(dst));
+                int64_t b = static_cast<int64_t>(readOpCast(src));
+
+                if(b == 0)
+                    throw std::runtime_error("Division by zero");
+                if(a == INT64_MIN && b == -1)
+                    throw std::runtime_error("Division overflow");
+
+                this->regs[R_TMP0.reg_no] = static_cast<uint64_t>(a % b);
+                writeOpCast(dst, static_cast<uint64_t>(a / b));
+
+                break;
+            }
+
+            //
+            // 32-bit forms work on the low halves, the unsigned ones zero-extend the result,
+            // the signed ones (I*32) sign-extend it
+            //
+
+            case Opcode::ADD32: {
+                uint32_t a = readOpCast(instr.operands[0]);
+                uint32_t b = readOpCast(instr.operands[1]);
+
+                writeOpCast(instr.operands[0], static_cast<uint32_t>(a + b));
+                break;
+            }
+
+            case Opcode::SUB32: {
+                uint32_t a = readOpCast(instr.operands[0]);
+                uint32_t b = readOpCast(instr.operands[1]);
+
+                writeOpCast(instr.operands[0], static_cast<uint32_t>(a - b));
+                break;
+            }
+
+            case Opcode::MUL32: {
+                uint32_t a = readOpCast(instr.operands[0]);
+                uint32_t b = readOpCast(instr.operands[1]);
+
+                writeOpCast(instr.operands[0], static_cast<uint32_t>(a * b));
+                break;
+            }
+
+            case Opcode::IADD32: {
+                uint32_t a = readOpCast(instr.operands[0]);
+                uint32_t b = readOpCast(instr.operands[1]);
+
+                writeOpCast(instr.operands[0], static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(a + b))));
+                break;
+            }
+
+            case Opcode::ISUB32: {
+                uint32_t a = readOpCast(instr.operands[0]);
+                uint32_t b = readOpCast(instr.operands[1]);
+
+                writeOpCast(instr.operands[0], static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(a - b))));
+                break;
+            }
+
+            case Opcode::IMUL32: {
+                uint32_t a = readOpCast(instr.operands[0]);
+                uint32_t b = readOpCast(instr.operands[1]);
+
+                writeOpCast(instr.operands[0], static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(a * b))));
+                break;
+            }
+
+            case Opcode::DIV32: {
+                uint32_t a = readOpCast(instr.operands[0]);
+                uint32_t b = readOpCast(instr.operands[1]);
+
+                if(b == 0)
+                    throw std::runtime_error("Division by zero");
+
+                this->regs[R_TMP0.reg_no] = a % b;
+                writeOpCast(instr.operands[0], a / b);
+
+                break;
+            }
+
+            case Opcode::IDIV32: {
+                int32_t a = static_cast<int32_t>(readOpCast(instr.operands[0]));
+                int32_t b = static_cast<int32_t>(readOpCast(instr.operands[1]));
+
+                if(b == 0)
+                    throw std::runtime_error("Division by zero");
+                if(a == INT32_MIN && b == -1)
+                    throw std::runtime_error("Division overflow");
+
+                this->regs[R_TMP0.reg_no] = static_cast<uint64_t>(static_cast<int64_t>(a % b));
+                writeOpCast(instr.operands[0], static_cast<uint64_t>(static_cast<int64_t>(a / b)));
 
                 break;
             }
@@ -291,10 +676,80 @@ namespace ULang {
                 break;
             }
 
+            case Opcode::LD8:   writeOpCast(instr.operands[0], this->loadSized(instr.operands[1], 1, false)); break;
+            case Opcode::LD16:  writeOpCast(instr.operands[0], this->loadSized(instr.operands[1], 2, false)); break;
+            case Opcode::LD32:  writeOpCast(instr.operands[0], this->loadSized(instr.operands[1], 4, false)); break;
+            case Opcode::LD8S:  writeOpCast(instr.operands[0], this->loadSized(instr.operands[1], 1, true));  break;
+            case Opcode::LD16S: writeOpCast(instr.operands[0], this->loadSized(instr.operands[1], 2, true));  break;
+            case Opcode::LD32S: writeOpCast(instr.operands[0], this->loadSized(instr.operands[1], 4, true));  break;
+
+            case Opcode::ST8:   this->storeSized(instr.operands[0], 1, readOpCast(instr.operands[1])); break;
+            case Opcode::ST16:  this->storeSized(instr.operands[0], 2, readOpCast(instr.operands[1])); break;
+            case Opcode::ST32:  this->storeSized(instr.operands[0], 4, readOpCast(instr.operands[1])); break;
+
+            case Opcode::MEMCPY: {
+                //
+                // [DST..DST+CNT] = [SRC..SRC+CNT]
+                //
+
+                uint64_t n = this->regs[R_CNT.reg_no];
+                uint8_t* dst = this->castOperandAddress(instr.operands[0], n);
+                uint8_t* src = this->castOperandAddress(instr.operands[1], n);
+
+                memmove(dst, src, n);
+                break;
+            }
+
+            case Opcode::MEMSET: {
+                //
+                // [DST..DST+CNT] = (uint8_t) [VAL]
+                //
+
+                uint64_t n = this->regs[R_CNT.reg_no];
+                uint8_t* dst = this->castOperandAddress(instr.operands[0], n);
+                uint64_t val = this->readOpCast(instr.operands[1]);
+
+                memset(dst, static_cast<uint8_t>(val), n);
+                break;
+            }
+
+            case Opcode::MEMCMP: {
+                //
+                // [TMP0] = sign(memcmp([A..A+CNT], [B..B+CNT]))
+                //
+
+                uint64_t n = this->regs[R_CNT.reg_no];
+                const uint8_t* a = this->castOperandAddress(instr.operands[0], n);
+                const uint8_t* b = this->castOperandAddress(instr.operands[1], n);
+
+                int res = memcmp(a, b, n);
+                this->regs[R_TMP0.reg_no] = static_cast<uint64_t>(static_cast<int64_t>((res > 0) - (res < 0)));
+                break;
+            }
+
+            case Opcode::VLD:
+            case Opcode::VST:
+            case Opcode::VBCAST:
+            case Opcode::VADD:
+            case Opcode::VSUB:
+            case Opcode::VMUL:
+            case Opcode::VMIN:
+            case Opcode::VMAX:
+            case Opcode::VCMPEQ:
+            case Opcode::VCMPGT:
+            case Opcode::VRSUM:
+            case Opcode::VRMIN:
+            case Opcode::VRMAX:
+                this->executeVector(instr);
+                break;
+
             case Opcode::PUTC: {
                 uint32_t val = this->readOpCast(instr.operands[0]);
-                std::cout.put(static_cast<char>(val));
-                std::cout.flush();
+
+                IOPort& port = this->io.port(ULANG_IO_PORT_STDOUT);
+                if(!port.putc(static_cast<uint8_t>(val)))
+                    this->io_suspend(port, true);
+
                 break;
             }
 
@@ -302,11 +757,184 @@ namespace ULang {
                 //const Operand& dst = instr.operands[0];
                 //const Operand& src = instr.operands[1];
                 
-                int ch = std::cin.get();
-                if(ch == EOF) ch = 0;
+                IOPort& port = this->io.port(ULANG_IO_PORT_STDIN);
+
+                int ch = port.getc();
+                if(ch == ULANG_IO_WOULD_BLOCK) {
+                    this->io_suspend(port, false);
+                    break;
+                }
+
+                if(ch == ULANG_IO_EOF) ch = 0;
 
                 writeOpCast(instr.operands[0], ch);
+                break;
+            }
+
+            case Opcode::OUT: {
+                //
+                // port:[PORT] <- [VAL]
+                //
+
+                IOPort& port = this->io.port(this->readOpCast(instr.operands[0]));
+                uint64_t val = this->readOpCast(instr.operands[1]);
+
+                if(!port.putc(static_cast<uint8_t>(val)))
+                    this->io_suspend(port, true);
+
+                break;
+            }
+
+            case Opcode::IN: {
+                //
+                // [DST] <- port:[PORT]
+                //
+
+                IOPort& port = this->io.port(this->readOpCast(instr.operands[1]));
+
+                int ch = port.getc();
+                if(ch == ULANG_IO_WOULD_BLOCK) {
+                    this->io_suspend(port, false);
+                    break;
+                }
+
+                if(ch == ULANG_IO_EOF) ch = 0;
+
+                writeOpCast(instr.operands[0], ch);
+                break;
+            }
+
+            case Opcode::HALT: {
+                this->halt();
+                break;
+            }
+        }
+    }
+
+    void VirtualMachine::stack_push(uint64_t val) {
+        if(*this->sp < sizeof(uint64_t))
+            throw std::runtime_error("Stack overflow");
+
+        *this->sp -= sizeof(uint64_t);
+        memcpy(this->stack + *this->sp, &val, sizeof(uint64_t));
+    }
+
+    uint64_t VirtualMachine::stack_pop() {
+        if(*this->sp + sizeof(uint64_t) > this->STACK_SIZE)
+            throw std::runtime_error("Stack underflow");
+
+        uint64_t val;
+        memcpy(&val, this->stack + *this->sp, sizeof(uint64_t));
+        *this->sp += sizeof(uint64_t);
+
+        return val;
+    }
+
+    bool VirtualMachine::condition(Opcode op) const {
+        bool zf = *this->flags & ULANG_FLAG_ZF;
+        bool sf = *this->flags & ULANG_FLAG_SF;
+        bool cf = *this->flags & ULANG_FLAG_CF;
+        bool of = *this->flags & ULANG_FLAG_OF;
+
+        switch(op) {
+            case Opcode::JZ:    return zf;
+            case Opcode::JNE:   return !zf;
+            case Opcode::JL:    return sf != of;
+            case Opcode::JLE:   return zf || sf != of;
+            case Opcode::JG:    return !zf && sf == of;
+            case Opcode::JGE:   return sf == of;
+            case Opcode::JB:    return cf;
+            case Opcode::JBE:   return cf || zf;
+            case Opcode::JA:    return !cf && !zf;
+            case Opcode::JAE:   return !cf;
+
+            default:
+                return false;
+        }
+    }
+
+    VReg& VirtualMachine::vregOperand(const Operand& op) {
+        if(op.type != OperandType::OP_REGISTER || op.data >= ULANG_VREG_COUNT)
+            throw std::runtime_error("Excepted vector register");
+
+        return this->vregs[op.data];
+    }
+
+    void VirtualMachine::executeVector(const Instruction& instr) {
+        uint64_t vtype = this->regs[R_VTYPE.reg_no];
+
+        unsigned sew = vtype & ULANG_VTYPE_SEW_MASK;
+        int sgn = (vtype & ULANG_VTYPE_SIGNED) ? 1 : 0;
+        size_t n = (vtype & ULANG_VTYPE_VL256) ? 32 : 16;
+
+        VecBinop binop;
+        VecReduce reduce;
+
+        switch(instr.opcode) {
+            case Opcode::VLD: {
+                //
+                // v:[DST] = [REF..REF+VL]
+                //
+
+                VReg& dst = this->vregOperand(instr.operands[0]);
+                memcpy(dst.b, this->castOperandAddress(instr.operands[1], n), n);
+                return;
             }
+
+            case Opcode::VST: {
+                //
+                // [REF..REF+VL] = v:[SRC]
+                //
+
+                const VReg& src = this->vregOperand(instr.operands[1]);
+                memcpy(this->castOperandAddress(instr.operands[0], n), src.b, n);
+                return;
+            }
+
+            case Opcode::VBCAST: {
+                //
+                // v:[DST].lanes = [VAL]
+                //
+
+                VReg& dst = this->vregOperand(instr.operands[0]);
+                simdBroadcast(dst.b, this->readOpCast(instr.operands[1]), sew, n);
+                return;
+            }
+
+            case Opcode::VADD:      binop = VecBinop::ADD;   break;
+            case Opcode::VSUB:      binop = VecBinop::SUB;   break;
+            case Opcode::VMUL:      binop = VecBinop::MUL;   break;
+            case Opcode::VMIN:      binop = VecBinop::MIN;   break;
+            case Opcode::VMAX:      binop = VecBinop::MAX;   break;
+            case Opcode::VCMPEQ:    binop = VecBinop::CMPEQ; break;
+            case Opcode::VCMPGT:    binop = VecBinop::CMPGT; break;
+
+            case Opcode::VRSUM:
+            case Opcode::VRMIN:
+            case Opcode::VRMAX: {
+                //
+                // [DST] = REDUCE(v:[SRC].lanes)
+                //
+
+                reduce = instr.opcode == Opcode::VRSUM ? VecReduce::SUM :
+                         instr.opcode == Opcode::VRMIN ? VecReduce::MIN : VecReduce::MAX;
+
+                const VReg& src = this->vregOperand(instr.operands[1]);
+                this->writeOpCast(instr.operands[0], this->simd->reduce[static_cast<int>(reduce)][sew][sgn](src.b, n));
+                return;
+            }
+
+            default:
+                throw std::runtime_error("Invalid vector instruction");
         }
+
+        //
+        // v:[DST].lanes = (v:[DST].lanes OP v:[SRC].lanes)
+        //
+
+        VReg& dst = this->vregOperand(instr.operands[0]);
+        const VReg& src = this->vregOperand(instr.operands[1]);
+
+        this->simd->binop[static_cast<int>(binop)][sew][sgn](dst.b, src.b, n);
     }
 };
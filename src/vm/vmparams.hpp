@@ -13,6 +13,16 @@ namespace ULang {
 
         size_t heapsize_start_kb;
         size_t heapsize_limit_kb;
+
+        std::string io_backend;         ///< I/O port backend: "fd" (read(2)/write(2)) or "stream" (iostreams)
+        std::string io_flush;           ///< output flush policy: "line", "size" or "halt"
+        size_t io_bufsize_kb;           ///< I/O port buffer size in kilobytes
+
+        std::string forkServerSocket;   ///< UNIX socket path, empty if fork server mode disabled
+        std::string asyncServerSocket;  ///< UNIX socket path, empty if async (single thread, epoll) server mode disabled
+
+        std::string batchFile;          ///< record file for batch mode, empty if batch mode disabled
+        char batchDelim;                ///< batch record delimiter
     };
 };
 